@@ -0,0 +1,62 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "Logger/Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+/// <summary>
+/// Helpers shared by the benchmarks
+/// </summary>
+
+// Nanoseconds per operation of func(), which performs the given number of operations.
+// The best of the runs is kept, setup() is called before each run and is not timed
+template <typename TSetup, typename TFunc>
+double MeasureNsPerOp(int operations, TSetup setup, TFunc func, int runs = 5) {
+	double best = 1e30;
+	for (int run = 0; run < runs; run++) {
+		setup();
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		const auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / operations);
+	}
+	return best;
+}
+
+template <typename TFunc>
+double MeasureNsPerOp(int operations, TFunc func, int runs = 5) {
+	return MeasureNsPerOp(operations, [] {}, func, runs);
+}
+
+// Entity ids 0..count-1 in a random but repeatable order
+inline std::vector<int> ShuffledIds(int count) {
+	std::vector<int> ids(count);
+	for (int i = 0; i < count; i++) {
+		ids[i] = i;
+	}
+	std::shuffle(ids.begin(), ids.end(), std::mt19937(12345));
+	return ids;
+}
+
+// The registry logs every entity and component it creates: drop the output while it is alive.
+// The log messages are still formatted, and are released when the scope ends
+class QuietLog {
+	private:
+		std::streambuf* output;
+
+	public:
+		QuietLog() : output(std::cout.rdbuf(nullptr)) {}
+		~QuietLog() {
+			std::cout.rdbuf(output);
+			std::cout.clear();
+			Logger::messages.clear();
+			Logger::messages.shrink_to_fit();
+		}
+};
+
+#endif // !BENCH_H
@@ -0,0 +1,144 @@
+#include "Bench.h"
+#include "ECS/ECS.h"
+
+/// <summary>
+/// Chunk benchmark
+/// Iteration of 200k entities with a transform, a rigid body and a box collider (and half of them with a health
+/// component), stored in pools and stored in chunks. The pooled components are reached through a view, or one
+/// GetComponent per component like the systems do; the chunked ones through ViewChunks, chunk by chunk or per entity
+/// </summary>
+
+const int NUM_ENTITIES = 200000;
+
+template <bool Chunked>
+struct BenchTransform {
+	float x, y;
+	float scaleX, scaleY;
+	double rotation;
+};
+
+template <bool Chunked>
+struct BenchRigidBody {
+	float velocityX, velocityY;
+};
+
+template <bool Chunked>
+struct BenchBoxCollider {
+	int width, height;
+	float offsetX, offsetY;
+	float left, top;
+};
+
+template <bool Chunked>
+struct BenchHealth {
+	int health;
+};
+
+template <typename TComponent>
+struct ChunkedStorage {
+	static constexpr StoragePolicy policy = StoragePolicy::Chunked;
+};
+
+template <> struct ComponentStorage<BenchTransform<true>> : ChunkedStorage<BenchTransform<true>> {};
+template <> struct ComponentStorage<BenchRigidBody<true>> : ChunkedStorage<BenchRigidBody<true>> {};
+template <> struct ComponentStorage<BenchBoxCollider<true>> : ChunkedStorage<BenchBoxCollider<true>> {};
+template <> struct ComponentStorage<BenchHealth<true>> : ChunkedStorage<BenchHealth<true>> {};
+
+template <bool Chunked>
+class BenchSystem : public System {
+	public:
+		BenchSystem() {
+			RequireComponent<BenchTransform<Chunked>>();
+			RequireComponent<BenchRigidBody<Chunked>>();
+			RequireComponent<BenchBoxCollider<Chunked>>();
+		}
+};
+
+// The components are added in a random entity order, as entities spawned over the frames of a level would add them
+template <bool Chunked>
+void CreateEntities(Registry& registry) {
+	registry.AddSystem<BenchSystem<Chunked>>();
+	std::vector<Entity> entities = registry.CreateEntities(NUM_ENTITIES);
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> velocity(-100.0f, 100.0f);
+	for (int entityId : ShuffledIds(NUM_ENTITIES)) {
+		registry.AddComponent<BenchTransform<Chunked>>(entities[entityId], BenchTransform<Chunked>{ 100.0f, 100.0f, 1.0f, 1.0f, 0.0 });
+	}
+	for (int entityId : ShuffledIds(NUM_ENTITIES)) {
+		registry.AddComponent<BenchRigidBody<Chunked>>(entities[entityId], BenchRigidBody<Chunked>{ velocity(random), velocity(random) });
+		if (entityId % 2 == 0) {
+			registry.AddComponent<BenchHealth<Chunked>>(entities[entityId], BenchHealth<Chunked>{ 100 });
+		}
+	}
+	for (int entityId : ShuffledIds(NUM_ENTITIES)) {
+		registry.AddComponent<BenchBoxCollider<Chunked>>(entities[entityId], BenchBoxCollider<Chunked>{ 32, 32, 0.0f, 0.0f, 0.0f, 0.0f });
+	}
+	registry.Update();
+}
+
+template <bool Chunked>
+void Move(BenchTransform<Chunked>& transform, const BenchRigidBody<Chunked>& rigidbody, BenchBoxCollider<Chunked>& collider, float deltaTime) {
+	transform.x += rigidbody.velocityX * deltaTime;
+	transform.y += rigidbody.velocityY * deltaTime;
+	collider.left = transform.x + collider.offsetX;
+	collider.top = transform.y + collider.offsetY;
+}
+
+int main() {
+	QuietLog quietLog;
+	const float deltaTime = 1.0f / 60.0f;
+	double nsSystemPools = 0;
+	double nsViewPools = 0;
+	double nsEachChunks = 0;
+	double nsChunks = 0;
+	float checksum = 0;
+
+	{
+		using Transform = BenchTransform<false>;
+		using RigidBody = BenchRigidBody<false>;
+		using BoxCollider = BenchBoxCollider<false>;
+		Registry registry;
+		CreateEntities<false>(registry);
+		const auto& entities = registry.GetSystem<BenchSystem<false>>().GetSystemEntities();
+		nsSystemPools = MeasureNsPerOp(NUM_ENTITIES, [&] {
+			for (auto entity : entities) {
+				Move(registry.GetComponent<Transform>(entity), registry.GetComponent<RigidBody>(entity), registry.GetComponent<BoxCollider>(entity), deltaTime);
+			}
+		});
+		nsViewPools = MeasureNsPerOp(NUM_ENTITIES, [&] {
+			registry.View<Transform, RigidBody, BoxCollider>().Each([deltaTime](Entity, Transform& transform, const RigidBody& rigidbody, BoxCollider& collider) {
+				Move(transform, rigidbody, collider, deltaTime);
+			});
+		});
+		checksum += registry.GetComponent<Transform>(registry.GetEntity(0)).x;
+	}
+
+	{
+		using Transform = BenchTransform<true>;
+		using RigidBody = BenchRigidBody<true>;
+		using BoxCollider = BenchBoxCollider<true>;
+		Registry registry;
+		CreateEntities<true>(registry);
+		nsEachChunks = MeasureNsPerOp(NUM_ENTITIES, [&] {
+			registry.ViewChunks<Transform, RigidBody, BoxCollider>().Each([deltaTime](Entity, Transform& transform, const RigidBody& rigidbody, BoxCollider& collider) {
+				Move(transform, rigidbody, collider, deltaTime);
+			});
+		});
+		nsChunks = MeasureNsPerOp(NUM_ENTITIES, [&] {
+			registry.ViewChunks<Transform, RigidBody, BoxCollider>().EachChunk([deltaTime](Span<const int> entityIds, Span<Transform> transforms, Span<RigidBody> rigidbodies, Span<BoxCollider> colliders) {
+				for (size_t i = 0; i < entityIds.size(); i++) {
+					Move(transforms[i], rigidbodies[i], colliders[i], deltaTime);
+				}
+			});
+		});
+		checksum += registry.GetComponent<Transform>(registry.GetEntity(0)).x;
+	}
+
+	printf("Transform + rigid body + box collider of %d entities (ns per entity)\n", NUM_ENTITIES);
+	printf("  pools, system GetComponent : %8.2f\n", nsSystemPools);
+	printf("  pools, View Each           : %8.2f\n", nsViewPools);
+	printf("  chunks, Each               : %8.2f\n", nsEachChunks);
+	printf("  chunks, EachChunk          : %8.2f\n", nsChunks);
+	printf("(checksum %.1f)\n", checksum);
+	return 0;
+}
@@ -0,0 +1,74 @@
+#include "Bench.h"
+#include "ECS/ECS.h"
+#include <memory>
+#include <string>
+
+/// <summary>
+/// Clone benchmark
+/// Registry::CloneInto of a 50k entity world: four trivially copyable components on every entity, and a component
+/// holding a string on one entity in ten. The first clone builds the pools of the destination, the next ones
+/// copy into the pools it already has
+/// </summary>
+
+const int NUM_ENTITIES = 50000;
+
+struct BenchTransform {
+	float x, y;
+	float scaleX, scaleY;
+	double rotation;
+};
+
+struct BenchRigidBody {
+	float velocityX, velocityY;
+};
+
+struct BenchBoxCollider {
+	int width, height;
+	float offsetX, offsetY;
+};
+
+struct BenchHealth {
+	int health;
+};
+
+struct BenchName {
+	std::string name;
+};
+
+class BenchSystem : public System {
+	public:
+		BenchSystem() {
+			RequireComponent<BenchTransform>();
+			RequireComponent<BenchRigidBody>();
+		}
+};
+
+int main() {
+	QuietLog quietLog;
+
+	Registry world;
+	world.AddSystem<BenchSystem>();
+	std::vector<Entity> entities = world.CreateEntities(NUM_ENTITIES, BenchTransform{ 1.0f, 2.0f, 1.0f, 1.0f, 0.0 },
+		BenchRigidBody{ 3.0f, 4.0f }, BenchBoxCollider{ 32, 32, 0.0f, 0.0f }, BenchHealth{ 100 });
+	for (int i = 0; i < NUM_ENTITIES; i += 10) {
+		world.AddComponent<BenchName>(entities[i], BenchName{ "a name longer than the small string buffer " + std::to_string(i) });
+	}
+	world.Update();
+
+	std::unique_ptr<Registry> destination;
+	const double nsFirstClone = MeasureNsPerOp(1, [&] {
+		destination = std::make_unique<Registry>();
+		destination->AddSystem<BenchSystem>();
+	}, [&] {
+		world.CloneInto(*destination);
+	});
+	const double nsClone = MeasureNsPerOp(1, [&] {
+		world.CloneInto(*destination);
+	});
+
+	std::printf("CloneInto of %d entities, 5 components (ms per clone, best of 5)\n", NUM_ENTITIES);
+	std::printf("  new destination    : %8.3f\n", nsFirstClone / 1e6);
+	std::printf("  reused destination : %8.3f\n", nsClone / 1e6);
+	std::printf("(%zu entities in the destination system)\n", destination->GetSystem<BenchSystem>().GetSystemEntities().size());
+	return 0;
+}
@@ -0,0 +1,174 @@
+#include "Bench.h"
+#include "ECS/ECS.h"
+#include <unordered_map>
+#include <string>
+#include <new>
+#include <cstdlib>
+
+/// <summary>
+/// Emplace benchmark
+/// Heap allocations per added component. The component holds a string too long for the small string buffer,
+/// like the asset id of a sprite, so every copy of the component is an allocation
+/// </summary>
+
+const int NUM_ENTITIES = 10000;
+
+// Every allocation of the program goes through the replaced global operator new below
+static size_t numAllocations = 0;
+static size_t numAllocatedBytes = 0;
+
+void* operator new(size_t size) {
+	numAllocations++;
+	numAllocatedBytes += size;
+	if (void* memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	numAllocations++;
+	numAllocatedBytes += size;
+	const size_t align = static_cast<size_t>(alignment);
+	if (void* memory = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+
+struct BenchSprite {
+	std::string assetId;
+	int width;
+	int height;
+	int zIndex;
+
+	BenchSprite(std::string assetId = "", int width = 0, int height = 0, int zIndex = 0) :
+		assetId(std::move(assetId)), width(width), height(height), zIndex(zIndex) {}
+};
+
+// The same component copying its string argument, as SpriteComponent did
+struct CopyingSprite {
+	std::string assetId;
+	int width;
+	int height;
+	int zIndex;
+
+	CopyingSprite(std::string assetId = "", int width = 0, int height = 0, int zIndex = 0) {
+		this->assetId = assetId;
+		this->width = width;
+		this->height = height;
+		this->zIndex = zIndex;
+	}
+};
+
+const char* ASSET_ID = "jungle-tilemap-texture-atlas";
+
+// The add path before the emplace change: the component was built in AddComponent, passed by value to Set(),
+// then copy assigned into a slot that resize() had default constructed
+template <typename T>
+class CopyingPool {
+	private:
+		std::vector<T> data;
+		int size = 0;
+		std::unordered_map<int, int> entityIdToIndex;
+		std::unordered_map<int, int> indexToEntityId;
+
+	public:
+		CopyingPool(int capacity = 100) {
+			data.resize(capacity);
+		}
+
+		void Set(int entityId, T object) {
+			int index = size;
+			entityIdToIndex.emplace(entityId, index);
+			indexToEntityId.emplace(index, entityId);
+			if (index >= static_cast<int>(data.capacity())) {
+				data.resize(size * 2);
+			}
+			data[index] = object;
+			size++;
+		}
+
+		template <typename ...TArgs>
+		void Add(int entityId, TArgs&& ...args) {
+			T newComponent(std::forward<TArgs>(args)...);
+			Set(entityId, newComponent);
+		}
+};
+
+struct AllocationCount {
+	double allocations;
+	double bytes;
+};
+
+template <typename TFunc>
+AllocationCount CountPerAdd(TFunc func) {
+	const size_t allocationsBefore = numAllocations;
+	const size_t bytesBefore = numAllocatedBytes;
+	func();
+	return AllocationCount{
+		static_cast<double>(numAllocations - allocationsBefore) / NUM_ENTITIES,
+		static_cast<double>(numAllocatedBytes - bytesBefore) / NUM_ENTITIES
+	};
+}
+
+void PrintCount(const char* name, const AllocationCount& count) {
+	std::printf("%-44s %12.2f %12.1f\n", name, count.allocations, count.bytes);
+}
+
+int main() {
+	QuietLog quietLog;
+	const std::string assetId = ASSET_ID;
+
+	const AllocationCount copying = CountPerAdd([&] {
+		CopyingPool<CopyingSprite> pool;
+		for (int i = 0; i < NUM_ENTITIES; i++) {
+			pool.Add(i, assetId, 32, 32, 1);
+		}
+	});
+
+	const AllocationCount emplace = CountPerAdd([&] {
+		Pool<BenchSprite> pool;
+		for (int i = 0; i < NUM_ENTITIES; i++) {
+			pool.Emplace(i, assetId, 32, 32, 1);
+		}
+	});
+
+	const AllocationCount emplaceReserved = CountPerAdd([&] {
+		Pool<BenchSprite> pool(NUM_ENTITIES);
+		for (int i = 0; i < NUM_ENTITIES; i++) {
+			pool.Emplace(i, assetId, 32, 32, 1);
+		}
+	});
+
+	std::unique_ptr<Registry> registry = std::make_unique<Registry>();
+	std::vector<Entity> entities = registry->CreateEntities(NUM_ENTITIES);
+	const AllocationCount addComponent = CountPerAdd([&] {
+		for (auto entity : entities) {
+			registry->AddComponent<BenchSprite>(entity, assetId, 32, 32, 1);
+		}
+	});
+
+	std::unique_ptr<Registry> reservedRegistry = std::make_unique<Registry>();
+	reservedRegistry->ReserveComponents<BenchSprite>(NUM_ENTITIES);
+	std::vector<Entity> reservedEntities = reservedRegistry->CreateEntities(NUM_ENTITIES);
+	const AllocationCount addComponentReserved = CountPerAdd([&] {
+		for (auto entity : reservedEntities) {
+			reservedRegistry->AddComponent<BenchSprite>(entity, assetId, 32, 32, 1);
+		}
+	});
+
+	std::printf("%d components with a %zu character string, per added component\n", NUM_ENTITIES, assetId.size());
+	std::printf("%-44s %12s %12s\n", "", "allocations", "bytes");
+	PrintCount("temporary + copy into resized vector (old)", copying);
+	PrintCount("Pool::Emplace", emplace);
+	PrintCount("Pool::Emplace, reserved pool", emplaceReserved);
+	PrintCount("Registry::AddComponent", addComponent);
+	PrintCount("Registry::AddComponent, reserved pool", addComponentReserved);
+	return 0;
+}
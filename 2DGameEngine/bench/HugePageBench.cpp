@@ -0,0 +1,189 @@
+#include "Bench.h"
+#include "ECS/ECS.h"
+#include "ECS/MemoryResources.h"
+#include <fstream>
+#include <string>
+
+/// <summary>
+/// Huge page benchmark
+/// Iterates the pools of 1M entities allocated from the default resource, the 64 byte aligned resource and the
+/// huge page resource, and reports the page faults taken to fill the pools, the data TLB misses of a sequential
+/// and of a random order pass over the components, and the time per entity of each pass
+/// </summary>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+const int NUM_ENTITIES = 1000000;
+
+struct BenchTransform {
+	float x, y;
+	float scaleX, scaleY;
+	double rotation;
+	double padding;
+};
+
+struct BenchRigidBody {
+	float velocityX, velocityY;
+	float padding[6];
+};
+
+// Data TLB read misses of the calling thread, in user space. Not every virtual machine exposes the counter
+class TlbMissCounter {
+	private:
+		int fd;
+
+	public:
+		TlbMissCounter() {
+			perf_event_attr attributes = {};
+			attributes.type = PERF_TYPE_HW_CACHE;
+			attributes.size = sizeof(attributes);
+			attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+		}
+		~TlbMissCounter() {
+			if (fd != -1) {
+				close(fd);
+			}
+		}
+
+		bool IsAvailable() const {
+			return fd != -1;
+		}
+
+		void Start() {
+			if (fd != -1) {
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+
+		long long Stop() {
+			long long count = -1;
+			if (fd != -1) {
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+				if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+					count = -1;
+				}
+			}
+			return count;
+		}
+};
+
+long GetMinorPageFaults() {
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_minflt;
+}
+
+// Kilobytes of the process memory backed by huge pages, transparent or reserved
+long GetHugePagesKb() {
+	std::ifstream smaps("/proc/self/smaps_rollup");
+	std::string line;
+	long total = 0;
+	while (std::getline(smaps, line)) {
+		if (line.rfind("AnonHugePages:", 0) == 0 || line.rfind("Private_Hugetlb:", 0) == 0) {
+			total += std::stol(line.substr(line.find(':') + 1));
+		}
+	}
+	return total;
+}
+
+struct PassResults {
+	long pageFaults;
+	long hugePagesKb;
+	double sequentialNs;
+	long long sequentialTlbMisses;
+	double randomNs;
+	long long randomTlbMisses;
+};
+
+PassResults Run(std::pmr::memory_resource* resource, const std::vector<int>& randomIds, double& checksum) {
+	QuietLog quietLog;
+	PassResults results;
+	std::unique_ptr<Registry> registry = std::make_unique<Registry>();
+	if (resource) {
+		registry->SetMemoryResource(resource);
+	}
+
+	const long hugePagesBefore = GetHugePagesKb();
+	const long faultsBefore = GetMinorPageFaults();
+	registry->CreateEntities(NUM_ENTITIES, BenchTransform{ 1.0f, 2.0f, 1.0f, 1.0f, 0.0, 0.0 }, BenchRigidBody{ 0.5f, 0.25f, {} });
+	results.pageFaults = GetMinorPageFaults() - faultsBefore;
+	results.hugePagesKb = GetHugePagesKb() - hugePagesBefore;
+	registry->Update();
+
+	TlbMissCounter tlbMisses;
+	auto transforms = registry->GetComponents<BenchTransform>();
+	auto rigidBodies = registry->GetComponents<BenchRigidBody>();
+
+	tlbMisses.Start();
+	results.sequentialNs = MeasureNsPerOp(NUM_ENTITIES, [&] {
+		for (size_t i = 0; i < transforms.size(); i++) {
+			transforms[i].x += rigidBodies[i].velocityX;
+			transforms[i].y += rigidBodies[i].velocityY;
+		}
+	});
+	results.sequentialTlbMisses = tlbMisses.Stop();
+
+	tlbMisses.Start();
+	results.randomNs = MeasureNsPerOp(NUM_ENTITIES, [&] {
+		for (const int entityId : randomIds) {
+			auto& transform = registry->GetComponent<BenchTransform>(Entity(entityId));
+			transform.x += registry->GetComponent<BenchRigidBody>(Entity(entityId)).velocityX;
+		}
+	});
+	results.randomTlbMisses = tlbMisses.Stop();
+
+	checksum += transforms[0].x + transforms[transforms.size() - 1].y;
+	return results;
+}
+
+// A TLB miss count, or n/a when the counter is not available
+std::string FormatTlbMisses(long long count) {
+	return count < 0 ? std::string("n/a") : std::to_string(count);
+}
+
+void PrintResults(const char* name, const PassResults& results) {
+	std::printf("%-20s %12ld %10ld %10.2f %14s %10.2f %14s\n", name, results.pageFaults, results.hugePagesKb,
+		results.sequentialNs, FormatTlbMisses(results.sequentialTlbMisses).c_str(), results.randomNs, FormatTlbMisses(results.randomTlbMisses).c_str());
+}
+
+int main() {
+	const std::vector<int> randomIds = ShuffledIds(NUM_ENTITIES);
+	double checksum = 0.0;
+
+	AlignedMemoryResource alignedResource;
+	HugePageMemoryResource hugePageResource;
+	const PassResults defaultResults = Run(nullptr, randomIds, checksum);
+	const PassResults alignedResults = Run(&alignedResource, randomIds, checksum);
+	const PassResults hugePageResults = Run(&hugePageResource, randomIds, checksum);
+
+	std::printf("%d entities with two 32 byte components, TLB misses over the 5 timed passes\n", NUM_ENTITIES);
+	std::printf("%-20s %12s %10s %10s %14s %10s %14s\n", "", "page faults", "THP kB", "seq ns", "seq dTLB miss", "rand ns", "rand dTLB miss");
+	PrintResults("default", defaultResults);
+	PrintResults("aligned 64", alignedResults);
+	PrintResults("huge pages", hugePageResults);
+	if (defaultResults.sequentialTlbMisses < 0) {
+		std::printf("The dTLB miss counter is not available (perf_event_open failed), the page faults to fill the pools\n"
+			"stand in for it: each fault maps one page, and one TLB entry covers one page\n");
+	}
+	std::printf("(checksum %g)\n", checksum);
+	return 0;
+}
+
+#else
+
+int main() {
+	std::printf("The huge page resource is only available on Linux\n");
+	return 0;
+}
+
+#endif // __linux__
@@ -0,0 +1,130 @@
+#include "Bench.h"
+#include "ECS/ECS.h"
+#include <tuple>
+
+/// <summary>
+/// Movement benchmark
+/// The position update of the movement system over 100k moving entities, with the transforms and rigid bodies
+/// stored as structs (the previous pools, one lambda call per entity) and stored as columns (one array per field,
+/// a plain loop over the arrays of the owning group)
+/// </summary>
+
+const int NUM_ENTITIES = 100000;
+
+struct StructTransform {
+	float x, y;
+	float scaleX, scaleY;
+	double rotation;
+};
+
+struct StructRigidBody {
+	float velocityX, velocityY;
+};
+
+struct ColumnTransform {
+	float x, y;
+	float scaleX, scaleY;
+	double rotation;
+
+	enum Column { PositionX, PositionY, ScaleX, ScaleY, Rotation };
+};
+
+struct ColumnRigidBody {
+	float velocityX, velocityY;
+
+	enum Column { VelocityX, VelocityY };
+};
+
+template <>
+struct ComponentStorage<ColumnTransform> {
+	static constexpr StoragePolicy policy = StoragePolicy::Columns;
+
+	static std::tuple<float, float, float, float, double> ToColumns(const ColumnTransform& transform) {
+		return std::make_tuple(transform.x, transform.y, transform.scaleX, transform.scaleY, transform.rotation);
+	}
+
+	static ColumnTransform FromColumns(float x, float y, float scaleX, float scaleY, double rotation) {
+		return ColumnTransform{ x, y, scaleX, scaleY, rotation };
+	}
+};
+
+template <>
+struct ComponentStorage<ColumnRigidBody> {
+	static constexpr StoragePolicy policy = StoragePolicy::Columns;
+
+	static std::tuple<float, float> ToColumns(const ColumnRigidBody& rigidbody) {
+		return std::make_tuple(rigidbody.velocityX, rigidbody.velocityY);
+	}
+
+	static ColumnRigidBody FromColumns(float velocityX, float velocityY) {
+		return ColumnRigidBody{ velocityX, velocityY };
+	}
+};
+
+// Entities with both components, created in a random order, and as many static entities with a transform only
+template <typename TTransform, typename TRigidBody>
+void CreateMovingEntities(Registry& registry) {
+	std::mt19937 random(12345);
+	std::uniform_real_distribution<float> velocity(-100.0f, 100.0f);
+	for (int i = 0; i < 2 * NUM_ENTITIES; i++) {
+		Entity entity = registry.CreateEntity();
+		entity.AddComponent<TTransform>(TTransform{ 100.0f, 100.0f, 1.0f, 1.0f, 0.0 });
+	}
+	for (int entityId : ShuffledIds(2 * NUM_ENTITIES)) {
+		if (entityId % 2 == 0) {
+			registry.AddComponent<TRigidBody>(registry.GetEntity(entityId), TRigidBody{ velocity(random), velocity(random) });
+		}
+	}
+	registry.Update();
+}
+
+int main() {
+	QuietLog quietLog;
+	const double deltaTime = 1.0 / 60.0;
+	double nsStructs = 0;
+	double nsColumns = 0;
+	float checksum = 0;
+
+	{
+		Registry registry;
+		CreateMovingEntities<StructTransform, StructRigidBody>(registry);
+		registry.OwnGroup<StructTransform, StructRigidBody>();
+		nsStructs = MeasureNsPerOp(NUM_ENTITIES, [&] {
+			for (int frame = 0; frame < 10; frame++) {
+				registry.OwnGroup<StructTransform, StructRigidBody>().Each([deltaTime](Entity, StructTransform& transform, const StructRigidBody& rigidbody) {
+					transform.x += rigidbody.velocityX * deltaTime;
+					transform.y += rigidbody.velocityY * deltaTime;
+				});
+			}
+		}) / 10;
+		checksum += registry.GetComponent<StructTransform>(registry.GetEntity(0)).x;
+	}
+
+	{
+		Registry registry;
+		CreateMovingEntities<ColumnTransform, ColumnRigidBody>(registry);
+		registry.OwnGroup<ColumnTransform, ColumnRigidBody>();
+		nsColumns = MeasureNsPerOp(NUM_ENTITIES, [&] {
+			for (int frame = 0; frame < 10; frame++) {
+				const auto group = registry.OwnGroup<ColumnTransform, ColumnRigidBody>();
+				const int size = group.GetSize();
+				float* positionX = group.GetColumn<ColumnTransform, ColumnTransform::PositionX>().data();
+				float* positionY = group.GetColumn<ColumnTransform, ColumnTransform::PositionY>().data();
+				const float* velocityX = group.GetColumn<ColumnRigidBody, ColumnRigidBody::VelocityX>().data();
+				const float* velocityY = group.GetColumn<ColumnRigidBody, ColumnRigidBody::VelocityY>().data();
+				const float step = static_cast<float>(deltaTime);
+				for (int i = 0; i < size; i++) {
+					positionX[i] += velocityX[i] * step;
+					positionY[i] += velocityY[i] * step;
+				}
+			}
+		}) / 10;
+		checksum += registry.GetComponent<ColumnTransform>(registry.GetEntity(0)).x;
+	}
+
+	printf("Movement update of %d entities (ns per entity)\n", NUM_ENTITIES);
+	printf("  structs, Each : %8.2f\n", nsStructs);
+	printf("  columns, loop : %8.2f\n", nsColumns);
+	printf("(checksum %.1f)\n", checksum);
+	return 0;
+}
@@ -0,0 +1,130 @@
+#include "Bench.h"
+#include "ECS/ECS.h"
+#include <unordered_map>
+
+/// <summary>
+/// Pool benchmark
+/// Throughput of the component pool against the previous pool, which mapped entity ids to indices with two
+/// std::unordered_map. The entity ids are visited in a random order, like the lookups of the systems
+/// </summary>
+
+const int NUM_ENTITIES = 100000;
+
+struct BenchTransform {
+	float x, y;
+	float scaleX, scaleY;
+	double rotation;
+};
+
+// The pool before the sparse set, kept as the baseline
+template <typename T>
+class HashedPool {
+	private:
+		std::vector<T> data;
+		int size;
+		std::unordered_map<int, int> entityIdToIndex;
+		std::unordered_map<int, int> indexToEntityId;
+
+	public:
+		HashedPool(int capacity = 100) {
+			size = 0;
+			data.resize(capacity);
+		}
+
+		void Set(int entityId, T object) {
+			if (entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
+				int index = entityIdToIndex[entityId];
+				data[index] = object;
+			}
+			else {
+				int index = size;
+				entityIdToIndex.emplace(entityId, index);
+				indexToEntityId.emplace(index, entityId);
+				if (index >= static_cast<int>(data.capacity())) {
+					data.resize(size * 2);
+				}
+				data[index] = object;
+				size++;
+			}
+		}
+
+		void Remove(int entityId) {
+			int indexOfRemoved = entityIdToIndex[entityId];
+			int indexOfLast = size - 1;
+			data[indexOfRemoved] = data[indexOfLast];
+
+			int entityIdOfLastElement = indexToEntityId[indexOfLast];
+			entityIdToIndex[entityIdOfLastElement] = indexOfRemoved;
+			indexToEntityId[indexOfRemoved] = entityIdOfLastElement;
+
+			entityIdToIndex.erase(entityId);
+			indexToEntityId.erase(indexOfLast);
+
+			size--;
+		}
+
+		T& Get(int entityId) {
+			int index = entityIdToIndex[entityId];
+			return data[index];
+		}
+};
+
+struct PoolResults {
+	double setNs;
+	double getNs;
+	double removeNs;
+};
+
+template <typename TPool>
+PoolResults RunPool(const std::vector<int>& ids, double& checksum) {
+	PoolResults results;
+	std::unique_ptr<TPool> pool;
+	const BenchTransform transform{ 1.0f, 2.0f, 1.0f, 1.0f, 0.0 };
+
+	results.setNs = MeasureNsPerOp(NUM_ENTITIES, [&] { pool.reset(new TPool()); }, [&] {
+		for (const int id : ids) {
+			pool->Set(id, transform);
+		}
+	});
+
+	results.getNs = MeasureNsPerOp(NUM_ENTITIES, [&] {
+		float sum = 0.0f;
+		for (const int id : ids) {
+			sum += pool->Get(id).x;
+		}
+		checksum += sum;
+	});
+
+	results.removeNs = MeasureNsPerOp(NUM_ENTITIES, [&] {
+		pool.reset(new TPool());
+		for (const int id : ids) {
+			pool->Set(id, transform);
+		}
+	}, [&] {
+		for (const int id : ids) {
+			pool->Remove(id);
+		}
+	});
+
+	return results;
+}
+
+void PrintResults(const char* name, const PoolResults& results) {
+	std::printf("%-28s %10.1f %10.1f %10.1f\n", name, results.setNs, results.getNs, results.removeNs);
+}
+
+int main() {
+	const std::vector<int> ids = ShuffledIds(NUM_ENTITIES);
+	double checksum = 0.0;
+
+	const PoolResults hashed = RunPool<HashedPool<BenchTransform>>(ids, checksum);
+	const PoolResults paged = RunPool<Pool<BenchTransform>>(ids, checksum);
+
+	std::printf("%d entities, random order, ns per operation (best of 5)\n", NUM_ENTITIES);
+	std::printf("%-28s %10s %10s %10s\n", "", "set", "get", "remove");
+	PrintResults("unordered_map pool", hashed);
+	PrintResults("paged sparse set pool", paged);
+	std::printf("%-28s %9.1fx %9.1fx %9.1fx\n", "speedup", hashed.setNs / paged.setNs, hashed.getNs / paged.getNs, hashed.removeNs / paged.removeNs);
+	std::printf("(checksum %g)\n", checksum);
+	return 0;
+}
@@ -2,6 +2,7 @@
 #define ANIMATIONCOMPONENT_H
 
 #include <SDL.h>
+#include "ComponentList.h"
 
 struct AnimationComponent {
 	int numFrames;
@@ -19,4 +20,6 @@ struct AnimationComponent {
 	}
 };
 
+static_assert(GameComponents::Contains<AnimationComponent>(), "AnimationComponent must be listed in GameComponents to get its compile time id");
+
 #endif // !ANIMATIONCOMPONENT_H
\ No newline at end of file
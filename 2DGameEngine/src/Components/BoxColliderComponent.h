@@ -2,6 +2,7 @@
 #define BOXCOLLIDERCOMPONENT_H
 
 #include <glm/glm.hpp>
+#include "ComponentList.h"
 
 struct BoxColliderComponent
 {
@@ -16,4 +17,6 @@ struct BoxColliderComponent
 	}
 };
 
+static_assert(GameComponents::Contains<BoxColliderComponent>(), "BoxColliderComponent must be listed in GameComponents to get its compile time id");
+
 #endif // ! BOXCOLLIDERCPMPONENT_H
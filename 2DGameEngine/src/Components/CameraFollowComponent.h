@@ -1,8 +1,12 @@
 #ifndef CAMERAFOLLOWcOMPONENT_H
 #define CAMERAFOLLOWcOMPONENT_H
 
+#include "ComponentList.h"
+
 struct CameraFollowComponent {
 	CameraFollowComponent() = default;
 };
 
+static_assert(GameComponents::Contains<CameraFollowComponent>(), "CameraFollowComponent must be listed in GameComponents to get its compile time id");
+
 #endif // !CAMERAFOLLOWcOMPONENT_H
@@ -0,0 +1,43 @@
+#ifndef COMPONENTLIST_H
+#define COMPONENTLIST_H
+
+#include "../ECS/ECS.h"
+
+struct TransformComponent;
+struct RigidBodyComponent;
+struct SpriteComponent;
+struct AnimationComponent;
+struct BoxColliderComponent;
+struct KeyboardControlComponent;
+struct CameraFollowComponent;
+struct ProjectileEmitterComponent;
+struct ProjectileComponent;
+struct HealthComponent;
+struct TextLabelComponent;
+struct ParentComponent;
+
+// Components of the game, each one gets its index in the list as a compile time component id.
+// Every component header includes this file so the ids are known wherever the component is used
+using GameComponents = ComponentList<
+	TransformComponent,
+	RigidBodyComponent,
+	SpriteComponent,
+	AnimationComponent,
+	BoxColliderComponent,
+	KeyboardControlComponent,
+	CameraFollowComponent,
+	ProjectileEmitterComponent,
+	ProjectileComponent,
+	HealthComponent,
+	TextLabelComponent,
+	ParentComponent
+>;
+
+static_assert(GameComponents::size <= NUM_STATIC_COMPONENTS, "Too many components in the list, increase ECS_STATIC_COMPONENTS");
+
+template <typename TComponent>
+struct StaticComponentId<TComponent, std::enable_if_t<GameComponents::Contains<TComponent>()>> {
+	static constexpr int value = GameComponents::IdOf<TComponent>();
+};
+
+#endif // !COMPONENTLIST_H
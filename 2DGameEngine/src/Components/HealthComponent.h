@@ -1,9 +1,13 @@
 #pragma once
 
+#include "ComponentList.h"
+
 struct HealthComponent {
 	int heathPercentage;
 
 	HealthComponent(int healthPercentage = 0) {
 		this->heathPercentage = healthPercentage;
 	}
-};
\ No newline at end of file
+};
+
+static_assert(GameComponents::Contains<HealthComponent>(), "HealthComponent must be listed in GameComponents to get its compile time id");
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define KEYBOARDCOMPONENT_H
 
 #include <glm/glm.hpp>
+#include "../ECS/ECS.h"
+#include "ComponentList.h"
 
 struct KeyboardControlComponent
 {
@@ -22,5 +24,13 @@ struct KeyboardControlComponent
 	}
 };
 
+static_assert(GameComponents::Contains<KeyboardControlComponent>(), "KeyboardControlComponent must be listed in GameComponents to get its compile time id");
+
+// Only the player is keyboard controlled
+template <>
+struct ComponentStorage<KeyboardControlComponent> {
+	static constexpr StoragePolicy policy = StoragePolicy::Sparse;
+};
+
 
 #endif // !KEYBOARDCOMPONENT_H
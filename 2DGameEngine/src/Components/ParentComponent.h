@@ -0,0 +1,30 @@
+#ifndef PARENTCOMPONENT_H
+#define PARENTCOMPONENT_H
+
+#include <glm/glm.hpp>
+#include "../ECS/ECS.h"
+#include "ComponentList.h"
+
+// Attaches an entity to a parent entity: the HierarchySystem computes the world TransformComponent
+// of the entity from the transform of its parent and the local transform below
+struct ParentComponent {
+	Entity parent;
+	glm::vec2 localPosition;
+	glm::vec2 localScale;
+	double localRotation;
+
+	ParentComponent(Entity parent = Entity(-1, -1), glm::vec2 localPosition = glm::vec2(0, 0), glm::vec2 localScale = glm::vec2(1, 1), double localRotation = 0.0) : parent(parent) {
+		this->localPosition = localPosition;
+		this->localScale = localScale;
+		this->localRotation = localRotation;
+	}
+
+	// Follow the parent when the entity is merged into another registry
+	void RemapEntities(const EntityMap& entityMap) {
+		parent = entityMap.Map(parent);
+	}
+};
+
+static_assert(GameComponents::Contains<ParentComponent>(), "ParentComponent must be listed in GameComponents to get its compile time id");
+
+#endif // !PARENTCOMPONENT_H
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SDL.h>
+#include "ComponentList.h"
 
 struct ProjectileComponent {
 	bool isFriendly;
@@ -15,3 +16,5 @@ struct ProjectileComponent {
 		this->startTime = SDL_GetTicks();
 	}
 };
+
+static_assert(GameComponents::Contains<ProjectileComponent>(), "ProjectileComponent must be listed in GameComponents to get its compile time id");
@@ -3,6 +3,7 @@
 
 #include <SDL.h>
 #include <glm/glm.hpp>
+#include "ComponentList.h"
 
 struct ProjectileEmitterComponent
 {
@@ -23,4 +24,6 @@ struct ProjectileEmitterComponent
 	}
 };
 
+static_assert(GameComponents::Contains<ProjectileEmitterComponent>(), "ProjectileEmitterComponent must be listed in GameComponents to get its compile time id");
+
 #endif // !PROJECTILEEMITTERCOMPONENT_H
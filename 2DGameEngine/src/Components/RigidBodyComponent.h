@@ -2,14 +2,35 @@
 #define RIGIDBODYCOMPONENT_H
 
 #include <glm/glm.hpp>
+#include <tuple>
+#include "ComponentList.h"
 
 struct RigidBodyComponent {
 	glm::vec2 velocity;
 
+	// Fields of the pool, stored one per array (see the ComponentStorage specialization below)
+	enum Column { VelocityX, VelocityY };
+
 	RigidBodyComponent(glm::vec2 velocity = glm::vec2(0.0, 0.0)) {
 		this->velocity = velocity;
 	}
 };
 
+static_assert(GameComponents::Contains<RigidBodyComponent>(), "RigidBodyComponent must be listed in GameComponents to get its compile time id");
+
+// Read every frame by the movement system, next to the positions: one array per field
+template <>
+struct ComponentStorage<RigidBodyComponent> {
+	static constexpr StoragePolicy policy = StoragePolicy::Columns;
+
+	static std::tuple<float, float> ToColumns(const RigidBodyComponent& rigidbody) {
+		return std::make_tuple(rigidbody.velocity.x, rigidbody.velocity.y);
+	}
+
+	static RigidBodyComponent FromColumns(float velocityX, float velocityY) {
+		return RigidBodyComponent(glm::vec2(velocityX, velocityY));
+	}
+};
+
 #endif // ! RIGIDBODYCOMPONENT_H
 
@@ -2,7 +2,9 @@
 #define SPRITECOMPONENT_H
 
 #include <string>
+#include <utility>
 #include <SDL.h>
+#include "ComponentList.h"
 
 struct SpriteComponent {
 	std::string assetId;
@@ -14,7 +16,7 @@ struct SpriteComponent {
 	SDL_Rect srcRect;
 
 	SpriteComponent(std::string assetId = "", int width = 0, int height = 0, int zIndex = 0, bool isFixed = false, int srcRectX = 0, int srcRectY = 0) {
-		this->assetId = assetId;
+		this->assetId = std::move(assetId);
 		this->width = width;
 		this->height = height;
 		this->zIndex = zIndex;
@@ -24,4 +26,6 @@ struct SpriteComponent {
 	}
 };
 
+static_assert(GameComponents::Contains<SpriteComponent>(), "SpriteComponent must be listed in GameComponents to get its compile time id");
+
 #endif // !TRANSFOMRCOMPONENT_H
\ No newline at end of file
@@ -2,7 +2,10 @@
 
 #include <SDL.h>
 #include <string>
+#include <utility>
 #include <glm/glm.hpp>
+#include "../ECS/ECS.h"
+#include "ComponentList.h"
 
 struct TextLabelComponent {
 	glm::vec2 position;
@@ -13,9 +16,17 @@ struct TextLabelComponent {
 
 	TextLabelComponent(glm::vec2 position = glm::vec2(0), std::string text = "", std::string assetId = "", const SDL_Color& color = { 0,0,0 }, bool isFixed = true) {
 		this->position = position;
-		this->text = text;
-		this->assetId = assetId;
+		this->text = std::move(text);
+		this->assetId = std::move(assetId);
 		this->color = color;
 		this->isFixed = isFixed;
 	}
+};
+
+static_assert(GameComponents::Contains<TextLabelComponent>(), "TextLabelComponent must be listed in GameComponents to get its compile time id");
+
+// Only a few labels exist at a time
+template <>
+struct ComponentStorage<TextLabelComponent> {
+	static constexpr StoragePolicy policy = StoragePolicy::Sparse;
 };
\ No newline at end of file
@@ -2,12 +2,17 @@
 #define TRANSFOMRCOMPONENT_H
 
 #include <glm/glm.hpp>
+#include <tuple>
+#include "ComponentList.h"
 
 struct TransformComponent {
 	glm::vec2 position;
 	glm::vec2 scale;
 	double rotation;
 
+	// Fields of the pool, stored one per array (see the ComponentStorage specialization below)
+	enum Column { PositionX, PositionY, ScaleX, ScaleY, Rotation };
+
 	TransformComponent(glm::vec2 position = glm::vec2(0, 0), glm::vec2 scale = glm::vec2(1, 1), double rotation = 0.0) {
 		this->position = position;
 		this->scale = scale;
@@ -15,5 +20,21 @@ struct TransformComponent {
 	}
 };
 
+static_assert(GameComponents::Contains<TransformComponent>(), "TransformComponent must be listed in GameComponents to get its compile time id");
+
+// Moved every frame by the movement system, and read by the culling of the renderer: one array per field
+template <>
+struct ComponentStorage<TransformComponent> {
+	static constexpr StoragePolicy policy = StoragePolicy::Columns;
+
+	static std::tuple<float, float, float, float, double> ToColumns(const TransformComponent& transform) {
+		return std::make_tuple(transform.position.x, transform.position.y, transform.scale.x, transform.scale.y, transform.rotation);
+	}
+
+	static TransformComponent FromColumns(float positionX, float positionY, float scaleX, float scaleY, double rotation) {
+		return TransformComponent(glm::vec2(positionX, positionY), glm::vec2(scaleX, scaleY), rotation);
+	}
+};
+
 #endif // !TRANSFOMRCOMPONENT_H
 
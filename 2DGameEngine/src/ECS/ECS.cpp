@@ -1,35 +1,439 @@
 #include "ECS.h"
 #include "../Logger/Logger.h"
 
-int IComponent::nextId = 0;
+std::atomic<int> IComponent::nextId(0);
+std::atomic<int> IResource::nextId(0);
+
+int IComponent::NextRuntimeId() {
+	// The runtime ids count down until they meet the ids reserved for the component list
+	const int id = static_cast<int>(MAX_COMPONENTS) - 1 - nextId++;
+	if (id < NUM_STATIC_COMPONENTS) {
+		Logger::Err("Too many component types, the runtime id " + std::to_string(id) + " is reserved for the component list, increase ECS_MAX_COMPONENTS");
+	}
+	return id;
+}
+
+thread_local Registry* Registry::current = nullptr;
+
+NameTable Registry::tagNames;
+NameTable Registry::groupNames;
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// <summary>
 /// Entity
 /// </summary>
-int Entity::GetId() const {
-	return id;
+void Entity::Kill() {
+	Registry::GetCurrent()->KillEntity(*this);
 }
 
-void Entity::Kill() {
-	registry->KillEntity(*this);
+bool Entity::IsAlive() const {
+	return Registry::GetCurrent()->IsAlive(*this);
 }
 
 void Entity::Tag(const std::string& tag) {
-	registry->TagEntity(*this, tag);
+	Registry::GetCurrent()->TagEntity(*this, tag);
+}
+
+void Entity::Tag(int tagId) {
+	Registry::GetCurrent()->TagEntity(*this, tagId);
 }
 
 bool Entity::HasTag(const std::string& tag) const {
-	return registry->EntityHasTag(*this, tag);
+	return Registry::GetCurrent()->EntityHasTag(*this, tag);
+}
+
+bool Entity::HasTag(int tagId) const {
+	return Registry::GetCurrent()->EntityHasTag(*this, tagId);
 }
 
 void Entity::Group(const std::string& group) {
-	registry->GroupEntity(*this, group);
+	Registry::GetCurrent()->GroupEntity(*this, group);
+}
+
+void Entity::Group(int groupId) {
+	Registry::GetCurrent()->GroupEntity(*this, groupId);
 }
 
 bool Entity::BelongsToGroup(const std::string& group) const {
-	return registry->EntityBelongsToGroup(*this, group);
+	return Registry::GetCurrent()->EntityBelongsToGroup(*this, group);
+}
+
+bool Entity::BelongsToGroup(int groupId) const {
+	return Registry::GetCurrent()->EntityBelongsToGroup(*this, groupId);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// <summary>
+/// Chunk storage
+/// </summary>
+ChunkStorage::~ChunkStorage() {
+	Clear();
+}
+
+void ChunkStorage::SetMemoryResource(std::pmr::memory_resource* resource) {
+	this->resource = resource;
+}
+
+bool ChunkStorage::HasChunks() const {
+	for (const auto& archetype : archetypes) {
+		if (!archetype.chunks.empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int ChunkStorage::GetArchetypeId(const Signature& signature) {
+	auto archetypeId = archetypeIdPerSignature.find(signature);
+	if (archetypeId != archetypeIdPerSignature.end()) {
+		return archetypeId->second;
+	}
+
+	ChunkArchetype archetype;
+	archetype.signature = signature;
+	archetype.columnPerComponent.assign(MAX_COMPONENTS, -1);
+	size_t rowBytes = sizeof(int);
+	for (size_t componentId = 0; componentId < componentTypes.size(); componentId++) {
+		if (signature.test(componentId)) {
+			archetype.columnPerComponent[componentId] = static_cast<int>(archetype.componentIds.size());
+			archetype.componentIds.push_back(static_cast<int>(componentId));
+			archetype.componentSizes.push_back(componentTypes[componentId].size);
+			rowBytes += componentTypes[componentId].size;
+		}
+	}
+	archetype.columnOffsets.resize(archetype.componentIds.size());
+
+	// As many rows as fit in a chunk once every column is aligned
+	auto layOut = [&archetype, this](int capacity) {
+		size_t offset = capacity * sizeof(int);
+		for (size_t column = 0; column < archetype.componentIds.size(); column++) {
+			const size_t alignment = std::max(componentTypes[archetype.componentIds[column]].alignment, CHUNK_ALIGNMENT);
+			offset = (offset + alignment - 1) / alignment * alignment;
+			archetype.columnOffsets[column] = offset;
+			offset += capacity * archetype.componentSizes[column];
+		}
+		return offset;
+	};
+	int capacity = std::max(1, static_cast<int>(CHUNK_SIZE / rowBytes));
+	while (capacity > 1 && layOut(capacity) > CHUNK_SIZE) {
+		capacity--;
+	}
+	archetype.chunkCapacity = capacity;
+	archetype.chunkBytes = std::max(layOut(capacity), CHUNK_SIZE);
+
+	const int newArchetypeId = static_cast<int>(archetypes.size());
+	archetypes.push_back(std::move(archetype));
+	archetypeIdPerSignature.emplace(signature, newArchetypeId);
+	return newArchetypeId;
+}
+
+void ChunkStorage::AssureEntity(int entityId) {
+	if (entityId >= static_cast<int>(entityArchetypeIds.size())) {
+		entityArchetypeIds.resize(entityId + 1, -1);
+		entityRows.resize(entityId + 1, -1);
+	}
+}
+
+int ChunkStorage::AppendRow(int archetypeId, int entityId) {
+	auto& archetype = archetypes[archetypeId];
+	const int row = archetype.size;
+	if (row == static_cast<int>(archetype.chunks.size()) * archetype.chunkCapacity) {
+		archetype.chunks.push_back(static_cast<unsigned char*>(resource->allocate(archetype.chunkBytes, CHUNK_ALIGNMENT)));
+	}
+	archetype.size++;
+	archetype.GetEntityId(row) = entityId;
+
+	entityArchetypeIds[entityId] = archetypeId;
+	entityRows[entityId] = row;
+	return row;
+}
+
+void ChunkStorage::RemoveRow(int archetypeId, int row) {
+	auto& archetype = archetypes[archetypeId];
+	const int lastRow = archetype.size - 1;
+	for (size_t column = 0; column < archetype.componentIds.size(); column++) {
+		const auto& type = componentTypes[archetype.componentIds[column]];
+		void* component = archetype.GetComponent(row, static_cast<int>(column));
+		type.destroy(component);
+		if (row != lastRow) {
+			void* lastComponent = archetype.GetComponent(lastRow, static_cast<int>(column));
+			type.moveConstruct(component, lastComponent);
+			type.destroy(lastComponent);
+		}
+	}
+	if (row != lastRow) {
+		const int lastEntityId = archetype.GetEntityId(lastRow);
+		archetype.GetEntityId(row) = lastEntityId;
+		entityRows[lastEntityId] = row;
+	}
+	archetype.size--;
+
+	// Keep one empty chunk, so an entity going back and forth at a chunk boundary doesn't allocate every time
+	if (static_cast<int>(archetype.chunks.size()) - archetype.GetNumUsedChunks() > 1) {
+		resource->deallocate(archetype.chunks.back(), archetype.chunkBytes, CHUNK_ALIGNMENT);
+		archetype.chunks.pop_back();
+	}
+}
+
+void ChunkStorage::MoveEntity(int entityId, const Signature& signature) {
+	const int oldArchetypeId = entityArchetypeIds[entityId];
+	const int oldRow = entityRows[entityId];
+
+	// Entities without any chunked component have no row
+	int newArchetypeId = -1;
+	if (signature.any()) {
+		newArchetypeId = GetArchetypeId(signature);
+		const int newRow = AppendRow(newArchetypeId, entityId);
+		if (oldArchetypeId != -1) {
+			const auto& oldArchetype = archetypes[oldArchetypeId];
+			const auto& newArchetype = archetypes[newArchetypeId];
+			for (size_t column = 0; column < oldArchetype.componentIds.size(); column++) {
+				const int newColumn = newArchetype.columnPerComponent[oldArchetype.componentIds[column]];
+				if (newColumn != -1) {
+					componentTypes[oldArchetype.componentIds[column]].moveConstruct(
+						newArchetype.GetComponent(newRow, newColumn), oldArchetype.GetComponent(oldRow, static_cast<int>(column)));
+				}
+			}
+		}
+	}
+	else {
+		entityArchetypeIds[entityId] = -1;
+		entityRows[entityId] = -1;
+	}
+
+	// Destroys the moved-from components, and the ones the entity lost
+	if (oldArchetypeId != -1) {
+		RemoveRow(oldArchetypeId, oldRow);
+	}
+}
+
+bool ChunkStorage::Has(int entityId, int componentId) const {
+	if (entityId >= static_cast<int>(entityArchetypeIds.size()) || entityArchetypeIds[entityId] == -1) {
+		return false;
+	}
+	return archetypes[entityArchetypeIds[entityId]].columnPerComponent[componentId] != -1;
+}
+
+void ChunkStorage::Remove(int entityId, int componentId) {
+	if (!Has(entityId, componentId)) {
+		return;
+	}
+	Signature signature = archetypes[entityArchetypeIds[entityId]].signature;
+	signature.reset(componentId);
+	MoveEntity(entityId, signature);
+}
+
+void ChunkStorage::RemoveMissing(int entityId, const Signature& signature) {
+	if (entityId >= static_cast<int>(entityArchetypeIds.size()) || entityArchetypeIds[entityId] == -1) {
+		return;
+	}
+	const Signature& chunkSignature = archetypes[entityArchetypeIds[entityId]].signature;
+	if (!signature.ContainsAll(chunkSignature)) {
+		MoveEntity(entityId, chunkSignature & signature);
+	}
+}
+
+void ChunkStorage::RemoveEntity(int entityId) {
+	if (entityId >= static_cast<int>(entityArchetypeIds.size()) || entityArchetypeIds[entityId] == -1) {
+		return;
+	}
+	RemoveRow(entityArchetypeIds[entityId], entityRows[entityId]);
+	entityArchetypeIds[entityId] = -1;
+	entityRows[entityId] = -1;
+}
+
+void ChunkStorage::Clear() {
+	for (auto& archetype : archetypes) {
+		for (size_t column = 0; column < archetype.componentIds.size(); column++) {
+			const auto& type = componentTypes[archetype.componentIds[column]];
+			for (int row = 0; row < archetype.size; row++) {
+				type.destroy(archetype.GetComponent(row, static_cast<int>(column)));
+			}
+		}
+		for (auto chunk : archetype.chunks) {
+			resource->deallocate(chunk, archetype.chunkBytes, CHUNK_ALIGNMENT);
+		}
+	}
+	archetypes.clear();
+	archetypeIdPerSignature.clear();
+	entityArchetypeIds.clear();
+	entityRows.clear();
+	numPendingRemovals = 0;
+}
+
+void ChunkStorage::CopyTo(ChunkStorage& destination) const {
+	destination.Clear();
+	destination.componentTypes = componentTypes;
+	destination.entityArchetypeIds = entityArchetypeIds;
+	destination.entityRows = entityRows;
+	destination.numPendingRemovals = numPendingRemovals;
+
+	// The archetypes are created in the same order, so they keep their ids
+	for (const auto& archetype : archetypes) {
+		const int archetypeId = destination.GetArchetypeId(archetype.signature);
+		for (int row = 0; row < archetype.size; row++) {
+			destination.AppendRow(archetypeId, archetype.GetEntityId(row));
+			const auto& destinationArchetype = destination.archetypes[archetypeId];
+			for (size_t column = 0; column < archetype.componentIds.size(); column++) {
+				componentTypes[archetype.componentIds[column]].copyConstruct(
+					destinationArchetype.GetComponent(row, static_cast<int>(column)), archetype.GetComponent(row, static_cast<int>(column)));
+			}
+		}
+	}
+}
+
+void ChunkStorage::MoveInto(ChunkStorage& destination, const EntityMap& entityMap) {
+	if (componentTypes.size() > destination.componentTypes.size()) {
+		destination.componentTypes.resize(componentTypes.size());
+	}
+	for (size_t componentId = 0; componentId < componentTypes.size(); componentId++) {
+		if (componentTypes[componentId].destroy) {
+			destination.componentTypes[componentId] = componentTypes[componentId];
+		}
+	}
+
+	// The component ids are the same in every registry, so the columns are in the same order in both archetypes
+	for (const auto& archetype : archetypes) {
+		if (archetype.size == 0) {
+			continue;
+		}
+		const int destinationArchetypeId = destination.GetArchetypeId(archetype.signature);
+		for (int row = 0; row < archetype.size; row++) {
+			const int entityId = entityMap.MapId(archetype.GetEntityId(row)).GetId();
+			destination.AssureEntity(entityId);
+			const int destinationRow = destination.AppendRow(destinationArchetypeId, entityId);
+			const auto& destinationArchetype = destination.archetypes[destinationArchetypeId];
+			for (size_t column = 0; column < archetype.componentIds.size(); column++) {
+				const auto& type = componentTypes[archetype.componentIds[column]];
+				void* component = destinationArchetype.GetComponent(destinationRow, static_cast<int>(column));
+				type.moveConstruct(component, archetype.GetComponent(row, static_cast<int>(column)));
+				if (type.remapEntities) {
+					type.remapEntities(component, entityMap);
+				}
+			}
+		}
+	}
+}
+
+void ChunkStorage::ReleaseSpareChunks() {
+	for (auto& archetype : archetypes) {
+		while (static_cast<int>(archetype.chunks.size()) > archetype.GetNumUsedChunks()) {
+			resource->deallocate(archetype.chunks.back(), archetype.chunkBytes, CHUNK_ALIGNMENT);
+			archetype.chunks.pop_back();
+		}
+	}
+}
+
+PoolStats ChunkStorage::GetStats() const {
+	PoolStats stats;
+	for (const auto& archetype : archetypes) {
+		stats.size += archetype.size;
+		stats.capacity += static_cast<int>(archetype.chunks.size()) * archetype.chunkCapacity;
+		stats.bytes += archetype.chunks.size() * archetype.chunkBytes;
+	}
+	stats.bytes += (entityArchetypeIds.capacity() + entityRows.capacity()) * sizeof(int);
+	return stats;
+}
+
+const std::vector<ChunkArchetype>& ChunkStorage::GetArchetypes() const {
+	return archetypes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// <summary>
+/// Tags and groups
+/// </summary>
+int NameTable::GetId(const std::string& name) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto id = idPerName.find(name);
+	if (id != idPerName.end()) {
+		return id->second;
+	}
+	const int newId = static_cast<int>(names.size());
+	names.push_back(name);
+	idPerName.emplace(name, newId);
+	return newId;
+}
+
+int NameTable::FindId(const std::string& name) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto id = idPerName.find(name);
+	return id != idPerName.end() ? id->second : -1;
+}
+
+const std::string& NameTable::GetName(int id) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return names[id];
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// <summary>
+/// Prefab
+/// </summary>
+void Prefab::Group(const std::string& group) {
+	groupId = Registry::GetGroupId(group);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// <summary>
+/// Command buffer
+/// </summary>
+void* CommandBuffer::Allocate(size_t size, size_t alignment) {
+	while (currentBlock < blocks.size()) {
+		const size_t offset = (blockOffset + alignment - 1) / alignment * alignment;
+		if (alignment <= blocks[currentBlock].get_deleter().alignment && offset + size <= blockSizes[currentBlock]) {
+			blockOffset = offset + size;
+			return blocks[currentBlock].get() + offset;
+		}
+		currentBlock++;
+		blockOffset = 0;
+	}
+
+	// All blocks are full, add a new one at the end, so the blocks are still used in recording order
+	const size_t blockSize = std::max(COMMAND_BLOCK_SIZE, size);
+	const size_t blockAlignment = std::max(COMMAND_BLOCK_ALIGNMENT, alignment);
+	blocks.emplace_back(static_cast<unsigned char*>(::operator new[](blockSize, std::align_val_t(blockAlignment))), AlignedBlockDelete{ blockAlignment });
+	blockSizes.push_back(blockSize);
+	currentBlock = blocks.size() - 1;
+	blockOffset = size;
+	return blocks[currentBlock].get();
+}
+
+PendingEntity CommandBuffer::CreateEntity() {
+	const int pendingIndex = numPendingEntities++;
+	Record<CreateEntityCommand>(pendingIndex);
+	return PendingEntity{ pendingIndex };
+}
+
+void CommandBuffer::KillEntity(CommandTarget target) {
+	Record<KillEntityCommand>(target);
+}
+
+void CommandBuffer::Playback(Registry& registry) {
+	createdEntities.assign(numPendingEntities, Entity(-1, -1));
+	for (auto command : commands) {
+		command->Execute(registry, createdEntities);
+	}
+	Clear();
+}
+
+void CommandBuffer::Clear() {
+	for (auto command : commands) {
+		command->~ICommand();
+	}
+	commands.clear();
+	currentBlock = 0;
+	blockOffset = 0;
+	numPendingEntities = 0;
+}
+
+void CreateEntityCommand::Execute(Registry& registry, std::vector<Entity>& createdEntities) {
+	createdEntities[pendingIndex] = registry.CreateEntity();
+}
+
+void KillEntityCommand::Execute(Registry& registry, std::vector<Entity>& createdEntities) {
+	registry.KillEntity(target.Resolve(createdEntities));
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -37,165 +441,898 @@ bool Entity::BelongsToGroup(const std::string& group) const {
 /// System
 /// </summary>
 void System::AddEntityToSystem(Entity entity) {
+	const auto entityId = entity.GetId();
+	if (entityId >= static_cast<int>(entityPositions.size())) {
+		entityPositions.resize(entityId + 1, -1);
+	}
+	if (entityPositions[entityId] != -1) {
+		return;
+	}
+
+	entityPositions[entityId] = static_cast<int>(entities.size());
 	entities.push_back(entity);
+	membershipVersion++;
 }
 void System::RemoveEntityFromSystem(Entity entity) {
-	entities.erase(std::remove_if(entities.begin(), entities.end(), [&entity](Entity other) {
-		return entity == other;
-	}), entities.end());
+	const auto entityId = entity.GetId();
+	if (entityId >= static_cast<int>(entityPositions.size()) || entityPositions[entityId] == -1) {
+		return;
+	}
+
+	// Move the last entity into the removed position to keep the vector packed
+	const int position = entityPositions[entityId];
+	const Entity lastEntity = entities.back();
+	entities[position] = lastEntity;
+	entityPositions[lastEntity.GetId()] = position;
+	entities.pop_back();
+
+	entityPositions[entityId] = -1;
+	membershipVersion++;
+}
+void System::ClearSystemEntities() {
+	for (auto entity : entities) {
+		entityPositions[entity.GetId()] = -1;
+	}
+	entities.clear();
+	membershipVersion++;
 }
-std::vector<Entity> System::GetSystemEntities() const {
+
+void System::CopySystemEntities(const System& other) {
+	entities = other.entities;
+	entityPositions = other.entityPositions;
+	membershipVersion++;
+}
+
+const std::vector<Entity>& System::GetSystemEntities() const {
 	return entities;
 }
 const Signature& System::GetComponentSignature() const {
 	return componentSignature;
 }
+uint32_t System::GetMembershipVersion() const {
+	return membershipVersion;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// <summary>
 /// Registry
 /// </summary>
-Entity Registry::CreateEntity() { 
+Registry* Registry::GetCurrent() {
+	return current;
+}
+
+void Registry::MakeCurrent() {
+	current = this;
+}
+
+int Registry::AllocateEntityId() {
 	int entityId;
 
 	if (freeIds.empty()) {
+		if (numEntities >= MAX_ENTITIES) {
+			Logger::Err("Cannot create more than " + std::to_string(MAX_ENTITIES) + " entities");
+			return -1;
+		}
 		entityId = numEntities++;
 
-		// Make sure the entityComponentSignatures vector can hold the new entity
-		if (entityId >= entityComponentSignatures.size()) {
-			entityComponentSignatures.resize(entityId + 1);
+		// Make sure the per-entity vectors can hold the new entity
+		if (entityId >= static_cast<int>(entityComponentSignatures.size())) {
+			ResizeEntityVectors(entityId + 1);
 		}
 	}
 	else {
-		// Reuse an id 
+		// Reuse the lowest free id
 		entityId = freeIds.front();
-		freeIds.pop_front();
+		std::pop_heap(freeIds.begin(), freeIds.end(), std::greater<int>());
+		freeIds.pop_back();
+	}
+
+	return entityId;
+}
+
+int Registry::GetNumFreeEntityIds() const {
+	return MAX_ENTITIES - numEntities + static_cast<int>(freeIds.size());
+}
+
+void Registry::ResizeEntityVectors(int numEntityIds) {
+	entityComponentSignatures.resize(numEntityIds);
+	// The generations never shrink, so the handles of the ids released by Shrink() stay stale when the ids come back
+	if (numEntityIds > static_cast<int>(entityGenerations.size())) {
+		entityGenerations.resize(numEntityIds, 0);
+	}
+	entityArchetypeIds.resize(numEntityIds, -1);
+	entityArchetypeRows.resize(numEntityIds, -1);
+	entityHasChangedSignature.resize(numEntityIds, false);
+	tagPerEntity.resize(numEntityIds, -1);
+	entityGroupMasks.resize(numEntityIds);
+	entityIsPendingKill.resize(numEntityIds, false);
+}
+
+Entity Registry::CreateEntity() { 
+	const int entityId = AllocateEntityId();
+	if (entityId == -1) {
+		return Entity(-1, -1);
 	}
 
-	Entity entity(entityId);
-	entity.registry = this;
-	entitiesToBeAdded.insert(entity);
+	Entity entity(entityId, entityGenerations[entityId]);
+	entitiesToBeAdded.push_back(entity);
 
 	Logger::Log("entity created with id = " + std::to_string(entityId));
 
 	return entity;
 }
 
+std::vector<Entity> Registry::CreateEntities(int count) {
+	std::vector<Entity> entities;
+	if (count <= 0) {
+		if (count < 0) {
+			Logger::Err("Cannot create a negative number of entities (" + std::to_string(count) + ")");
+		}
+		return entities;
+	}
+	if (count > GetNumFreeEntityIds()) {
+		Logger::Err("Cannot create " + std::to_string(count) + " entities, only " + std::to_string(GetNumFreeEntityIds()) + " ids are left");
+		return entities;
+	}
+	entities.reserve(count);
+
+	// Grow the per-entity vectors once for the ids that can't be reused
+	const int numNewIds = count - static_cast<int>(freeIds.size());
+	if (numNewIds > 0 && numEntities + numNewIds > static_cast<int>(entityComponentSignatures.size())) {
+		ResizeEntityVectors(numEntities + numNewIds);
+	}
+	entitiesToBeAdded.reserve(entitiesToBeAdded.size() + count);
+
+	for (int i = 0; i < count; i++) {
+		const int entityId = AllocateEntityId();
+		entities.emplace_back(entityId, entityGenerations[entityId]);
+		entitiesToBeAdded.push_back(entities.back());
+	}
+
+	return entities;
+}
+
 void Registry::KillEntity(Entity entity) {
-	entitiesToBeKilled.insert(entity);
+	// Ignore stale handles, the id may already belong to a new entity
+	if (!IsAlive(entity) || entityIsPendingKill[entity.GetId()]) {
+		return;
+	}
+	entityIsPendingKill[entity.GetId()] = true;
+	entitiesToBeKilled.push_back(entity);
+}
+
+void Registry::KillGroup(const std::string& group) {
+	KillGroup(groupNames.FindId(group));
+}
+
+void Registry::KillGroup(int groupId) {
+	for (auto entity : GetEntitiesByGroup(groupId)) {
+		KillEntity(entity);
+	}
+}
+
+bool Registry::IsAlive(Entity entity) const {
+	const auto entityId = entity.GetId();
+	return entityId < static_cast<int>(entityGenerations.size()) &&
+		static_cast<int>(entityGenerations[entityId] & ENTITY_GENERATION_MASK) == entity.GetGeneration();
+}
+
+Entity Registry::GetEntity(int entityId) const {
+	return Entity(entityId, entityGenerations[entityId]);
 }
 
 void Registry::AddEntityToSystems(Entity entity) {
 	const auto entityId = entity.GetId();
 
-	// TODO: match
-	const auto& entityComponentSignature = entityComponentSignatures[entityId];
+	// The systems interested in the entity signature are cached per archetype
+	int archetypeId = entityArchetypeIds[entityId];
+	if (archetypeId == -1) {
+		archetypeId = GetArchetypeId(entityComponentSignatures[entityId]);
+	}
+
+	for (auto system : GetArchetypeSystems(archetypeId)) {
+		system->AddEntityToSystem(entity);
+	}
+}
+
+void Registry::RemoveEntityFromSystems(Entity entity) {
+	const int archetypeId = entityArchetypeIds[entity.GetId()];
+	if (archetypeId == -1) {
+		for (auto& system : systems) {
+			system.second->RemoveEntityFromSystem(entity);
+		}
+		return;
+	}
+
+	// Only the systems interested in the entity archetype can contain it
+	for (auto system : GetArchetypeSystems(archetypeId)) {
+		system->RemoveEntityFromSystem(entity);
+	}
+}
+
+const std::vector<System*>& Registry::GetArchetypeSystems(int archetypeId) {
+	auto& archetype = archetypes[archetypeId];
+
+	// Match the archetype signature against all systems, only once per set of active systems
+	if (archetype.systemsVersion != systemsVersion) {
+		archetype.systems.clear();
+		for (auto& system : systems) {
+			const auto& systemComponentSignature = system.second->GetComponentSignature();
+
+			bool isInterested = archetype.signature.ContainsAll(systemComponentSignature);
+
+			if (isInterested) {
+				archetype.systems.push_back(system.second.get());
+			}
+		}
+		archetype.systemsVersion = systemsVersion;
+	}
+	return archetype.systems;
+}
+
+int Registry::GetArchetypeId(const Signature& signature) {
+	auto archetypeId = archetypeIdPerSignature.find(signature);
+	if (archetypeId != archetypeIdPerSignature.end()) {
+		return archetypeId->second;
+	}
+
+	// First entity with this signature, create a new archetype for it
+	const int newArchetypeId = static_cast<int>(archetypes.size());
+	archetypes.emplace_back(signature);
+	archetypeIdPerSignature.emplace(signature, newArchetypeId);
+	return newArchetypeId;
+}
+
+void Registry::AddEntityToArchetype(Entity entity, int archetypeId) {
+	const auto entityId = entity.GetId();
+
+	auto& archetypeEntities = archetypes[archetypeId].entities;
+	entityArchetypeIds[entityId] = archetypeId;
+	entityArchetypeRows[entityId] = static_cast<int>(archetypeEntities.size());
+	archetypeEntities.push_back(entity);
+}
+
+void Registry::RemoveEntityFromArchetype(Entity entity) {
+	const auto entityId = entity.GetId();
+	const int archetypeId = entityArchetypeIds[entityId];
+	if (archetypeId == -1) {
+		return;
+	}
+
+	// Move the last entity of the archetype into the removed row to keep the list packed
+	auto& archetypeEntities = archetypes[archetypeId].entities;
+	const int row = entityArchetypeRows[entityId];
+	const Entity lastEntity = archetypeEntities.back();
+	archetypeEntities[row] = lastEntity;
+	entityArchetypeRows[lastEntity.GetId()] = row;
+	archetypeEntities.pop_back();
 
-	// Loop all the systems
-	for (auto& system : systems) {
-		const auto& systemComponentSignature = system.second->GetComponentSignature();
+	entityArchetypeIds[entityId] = -1;
+	entityArchetypeRows[entityId] = -1;
+}
 
-		bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+void Registry::OnSignatureChanged(Entity entity) {
+	const auto entityId = entity.GetId();
 
-		if (isInterested) {
-			system.second->AddEntityToSystem(entity);
+	// Entities that were not added to their systems yet will be matched with their final signature
+	if (entityArchetypeIds[entityId] == -1 || entityHasChangedSignature[entityId]) {
+		return;
+	}
+	entityHasChangedSignature[entityId] = true;
+	entitiesWithChangedSignature.push_back(entity);
+}
+
+void Registry::UpdateEntitySystems(Entity entity) {
+	const auto entityId = entity.GetId();
+	const auto& signature = entityComponentSignatures[entityId];
+
+	// Leave the owning groups before dropping any data, so the removal doesn't break their packing
+	UpdateEntityOwnedGroups(entityId);
+
+	// Drop the data of the components that were removed since the last update
+	for (size_t componentId = 0; componentId < componentPools.size(); componentId++) {
+		if (componentPools[componentId] && !signature.test(componentId)) {
+			componentPools[componentId]->RemoveEntityFromPool(entityId);
 		}
 	}
+	chunks.RemoveMissing(entityId, signature);
+
+	const int oldArchetypeId = entityArchetypeIds[entityId];
+	const Signature oldSignature = archetypes[oldArchetypeId].signature;
+	if (oldSignature == signature) {
+		return;
+	}
+	const int newArchetypeId = GetArchetypeId(signature);
+
+	// Only leave the systems that are no longer interested, and only join the newly interested ones
+	for (auto system : GetArchetypeSystems(oldArchetypeId)) {
+		const auto& systemComponentSignature = system->GetComponentSignature();
+		if (!signature.ContainsAll(systemComponentSignature)) {
+			system->RemoveEntityFromSystem(entity);
+		}
+	}
+	for (auto system : GetArchetypeSystems(newArchetypeId)) {
+		const auto& systemComponentSignature = system->GetComponentSignature();
+		if (!oldSignature.ContainsAll(systemComponentSignature)) {
+			system->AddEntityToSystem(entity);
+		}
+	}
+
+	RemoveEntityFromArchetype(entity);
+	AddEntityToArchetype(entity, newArchetypeId);
 }
 
-void Registry::RemoveEntityFromSystems(Entity entity) {
-	for (auto system : systems) {
-		system.second->RemoveEntityFromSystem(entity);
+bool Registry::IsPoolOwned(int componentId) const {
+	for (const auto& group : ownedGroups) {
+		if (group->signature.test(componentId)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void Registry::UpdateEntityOwnedGroups(int entityId) {
+	const auto& signature = entityComponentSignatures[entityId];
+
+	for (auto& group : ownedGroups) {
+		const bool matches = signature.ContainsAll(group->signature);
+		const bool isMember = group->Contains(entityId);
+
+		// Joining swaps the entity into the first slot after the group, leaving swaps it into the last slot of the group
+		if (matches && !isMember) {
+			for (auto pool : group->pools) {
+				pool->Swap(pool->IndexOf(entityId), group->size);
+			}
+			group->size++;
+		}
+		else if (!matches && isMember) {
+			group->size--;
+			for (auto pool : group->pools) {
+				pool->Swap(pool->IndexOf(entityId), group->size);
+			}
+		}
 	}
 }
 
+const std::vector<Archetype>& Registry::GetArchetypes() const {
+	return archetypes;
+}
+
+int Registry::GetTagId(const std::string& tag) {
+	return tagNames.GetId(tag);
+}
+
+int Registry::GetGroupId(const std::string& group) {
+	return groupNames.GetId(group);
+}
+
 void Registry::TagEntity(Entity entity, const std::string& tag) {
-	entityPerTag.emplace(tag, entity);
-	tagPerEntity.emplace(entity.GetId(), tag);
+	TagEntity(entity, GetTagId(tag));
 }
 
-bool Registry::EntityHasTag(Entity entity, const std::string& tag) const {
-	if (tagPerEntity.find(entity.GetId()) == tagPerEntity.end()) {
-		return false;
+void Registry::TagEntity(Entity entity, int tagId) {
+	if (tagId >= static_cast<int>(entityIdPerTag.size())) {
+		entityIdPerTag.resize(tagId + 1, -1);
 	}
-	return entityPerTag.find(tag)->second == entity;
+
+	// A tag names a single entity, and an entity has a single tag
+	RemoveEntityTag(entity);
+	const int previousEntityId = entityIdPerTag[tagId];
+	if (previousEntityId != -1) {
+		tagPerEntity[previousEntityId] = -1;
+	}
+	entityIdPerTag[tagId] = entity.GetId();
+	tagPerEntity[entity.GetId()] = tagId;
+}
+
+bool Registry::EntityHasTag(Entity entity, const std::string& tag) const {
+	return EntityHasTag(entity, tagNames.FindId(tag));
+}
+
+bool Registry::EntityHasTag(Entity entity, int tagId) const {
+	return tagId != -1 && IsAlive(entity) && tagPerEntity[entity.GetId()] == tagId;
 }
 
 Entity Registry::GetEntityByTag(const std::string& tag) const {
-	return entityPerTag.at(tag);
+	return GetEntityByTag(tagNames.FindId(tag));
+}
+
+Entity Registry::GetEntityByTag(int tagId) const {
+	if (tagId == -1 || tagId >= static_cast<int>(entityIdPerTag.size()) || entityIdPerTag[tagId] == -1) {
+		// No entity has the tag, return a handle that is never alive
+		Logger::Err("No entity has the tag id " + std::to_string(tagId));
+		return Entity(-1, -1);
+	}
+	const int entityId = entityIdPerTag[tagId];
+	return Entity(entityId, entityGenerations[entityId]);
 }
 
 void Registry::RemoveEntityTag(Entity entity) {
-	auto taggedEntity = tagPerEntity.find(entity.GetId());
-	if (taggedEntity != tagPerEntity.end()) {
-		auto tag = taggedEntity->second;
-		entityPerTag.erase(tag);
-		tagPerEntity.erase(taggedEntity);
+	const int tagId = tagPerEntity[entity.GetId()];
+	if (tagId != -1) {
+		entityIdPerTag[tagId] = -1;
+		tagPerEntity[entity.GetId()] = -1;
 	}
 }
 
 void Registry::GroupEntity(Entity entity, const std::string& group) {
-	entitiesPerGroup.emplace(group, std::set<Entity>());
-	entitiesPerGroup[group].emplace(entity);
-	groupPerEntity.emplace(entity.GetId(), group);
+	GroupEntity(entity, GetGroupId(group));
 }
 
-bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const {
-	if (entitiesPerGroup.find(group) == entitiesPerGroup.end()) {
-		return false;
+void Registry::GroupEntity(Entity entity, int groupId) {
+	const auto entityId = entity.GetId();
+	if (groupId >= static_cast<int>(MAX_GROUPS)) {
+		Logger::Err("Too many groups, an entity can only belong to the first " + std::to_string(MAX_GROUPS) + " groups");
+		return;
+	}
+	if (entityGroupMasks[entityId].test(groupId)) {
+		return;
 	}
 
-	auto groupEntities = entitiesPerGroup.at(group);
-	return groupEntities.find(entity.GetId()) != groupEntities.end();
+	if (groupId >= static_cast<int>(groups.size())) {
+		groups.resize(groupId + 1);
+	}
+	auto& group = groups[groupId];
+	if (entityId >= static_cast<int>(group.entityPositions.size())) {
+		group.entityPositions.resize(entityId + 1, -1);
+	}
+	group.entityPositions[entityId] = static_cast<int>(group.entities.size());
+	group.entities.push_back(entity);
+
+	entityGroupMasks[entityId].set(groupId);
 }
 
-std::vector<Entity> Registry::GetEntitiesByGroup(const std::string& group) const {
-	auto& setOfEntities = entitiesPerGroup.at(group);
-	return std::vector<Entity>(setOfEntities.begin(), setOfEntities.end());
+bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const {
+	return EntityBelongsToGroup(entity, groupNames.FindId(group));
+}
+
+bool Registry::EntityBelongsToGroup(Entity entity, int groupId) const {
+	return groupId != -1 && groupId < static_cast<int>(MAX_GROUPS) && IsAlive(entity) && 
+		entityGroupMasks[entity.GetId()].test(groupId);
+}
+
+Span<const Entity> Registry::GetEntitiesByGroup(const std::string& group) const {
+	return GetEntitiesByGroup(groupNames.FindId(group));
+}
+
+Span<const Entity> Registry::GetEntitiesByGroup(int groupId) const {
+	if (groupId == -1 || groupId >= static_cast<int>(groups.size())) {
+		return Span<const Entity>();
+	}
+	const auto& entities = groups[groupId].entities;
+	return Span<const Entity>(entities.data(), entities.size());
+}
+
+void Registry::RemoveEntityFromGroup(Entity entity, int groupId) {
+	const auto entityId = entity.GetId();
+	if (groupId == -1 || groupId >= static_cast<int>(MAX_GROUPS) || !entityGroupMasks[entityId].test(groupId)) {
+		return;
+	}
+
+	// Move the last member into the removed position to keep the group packed
+	auto& group = groups[groupId];
+	const int position = group.entityPositions[entityId];
+	const Entity lastEntity = group.entities.back();
+	group.entities[position] = lastEntity;
+	group.entityPositions[lastEntity.GetId()] = position;
+	group.entities.pop_back();
+	group.entityPositions[entityId] = -1;
+
+	entityGroupMasks[entityId].reset(groupId);
 }
 
 void Registry::RemoveEntityGroup(Entity entity) {
-	// if in group, remove entity from group 
-	auto groupedEntity = groupPerEntity.find(entity.GetId());
-	if (groupedEntity != groupPerEntity.end()) {
-		auto group = entitiesPerGroup.find(groupedEntity->second);
-		if (group != entitiesPerGroup.end()) {
-			auto entityInGroup = group->second.find(entity);
-			if (entityInGroup != group->second.end()) {
-				group->second.erase(entityInGroup);
+	// Remove the entity from all of its groups
+	const auto& groupMask = entityGroupMasks[entity.GetId()];
+	for (size_t groupId = 0; groupMask.any() && groupId < MAX_GROUPS; groupId++) {
+		if (groupMask.test(groupId)) {
+			RemoveEntityFromGroup(entity, static_cast<int>(groupId));
+		}
+	}
+}
+
+void Registry::ReserveEntities(int count) {
+	if (count > static_cast<int>(entityComponentSignatures.capacity())) {
+		entityComponentSignatures.reserve(count);
+		entityGenerations.reserve(count);
+		entityArchetypeIds.reserve(count);
+		entityArchetypeRows.reserve(count);
+		entityHasChangedSignature.reserve(count);
+		tagPerEntity.reserve(count);
+		entityGroupMasks.reserve(count);
+		entityIsPendingKill.reserve(count);
+	}
+}
+
+void Registry::SetMemoryResource(std::pmr::memory_resource* resource) {
+	for (const auto& componentPool : componentPools) {
+		if (componentPool) {
+			Logger::Err("The memory resource of the registry must be set before any pool is created");
+			return;
+		}
+	}
+	if (chunks.HasChunks()) {
+		Logger::Err("The memory resource of the registry must be set before any chunk is created");
+		return;
+	}
+	memoryResource = resource;
+	chunks.SetMemoryResource(resource);
+}
+
+std::pmr::memory_resource* Registry::GetPoolMemoryResource(int componentId) const {
+	if (componentId < static_cast<int>(componentMemoryResources.size()) && componentMemoryResources[componentId]) {
+		return componentMemoryResources[componentId];
+	}
+	return memoryResource;
+}
+
+void Registry::Shrink(size_t byteBudget) {
+	size_t bytesMoved = ShrinkEntityVectors();
+	chunks.ReleaseSpareChunks();
+
+	// Visit the pools round robin from where the last call stopped, a pool bigger than the whole budget is shrunk alone
+	const size_t numPools = componentPools.size();
+	for (size_t visited = 0; visited < numPools; visited++) {
+		if (shrinkCursor >= numPools) {
+			shrinkCursor = 0;
+		}
+		const auto& componentPool = componentPools[shrinkCursor];
+		const size_t cost = componentPool ? componentPool->GetShrinkCost() : 0;
+		if (cost > 0) {
+			if (bytesMoved > 0 && bytesMoved + cost > byteBudget) {
+				return;
+			}
+			componentPool->Shrink();
+			bytesMoved += cost;
+		}
+		shrinkCursor++;
+	}
+}
+
+size_t Registry::ShrinkEntityVectors() {
+	const size_t capacity = entityComponentSignatures.capacity();
+	const size_t numLiveIds = numEntities - freeIds.size();
+	if (capacity <= static_cast<size_t>(SHRINK_MIN_CAPACITY) || numLiveIds * SHRINK_OCCUPANCY_RATIO >= capacity || freeIds.empty()) {
+		return 0;
+	}
+
+	// Only the ids past the highest live id can be released
+	if (*std::max_element(freeIds.begin(), freeIds.end()) != numEntities - 1) {
+		return 0;
+	}
+
+	// Sorted in ascending order, the free ids are still a valid min-heap
+	std::sort(freeIds.begin(), freeIds.end());
+	while (!freeIds.empty() && freeIds.back() == numEntities - 1) {
+		freeIds.pop_back();
+		numEntities--;
+	}
+
+	// The released ids hold no state: drop their slots, and the memory past them once it's mostly unused
+	entityComponentSignatures.resize(numEntities);
+	entityArchetypeIds.resize(numEntities);
+	entityArchetypeRows.resize(numEntities);
+	entityHasChangedSignature.resize(numEntities);
+	tagPerEntity.resize(numEntities);
+	entityGroupMasks.resize(numEntities);
+	entityIsPendingKill.resize(numEntities);
+
+	const size_t shrinkCapacity = std::max(static_cast<size_t>(numEntities) * 2, static_cast<size_t>(SHRINK_MIN_CAPACITY));
+	if (shrinkCapacity >= capacity) {
+		return 0;
+	}
+	ShrinkCapacity(entityComponentSignatures, shrinkCapacity);
+	ShrinkCapacity(entityArchetypeIds, shrinkCapacity);
+	ShrinkCapacity(entityArchetypeRows, shrinkCapacity);
+	ShrinkCapacity(entityHasChangedSignature, shrinkCapacity);
+	ShrinkCapacity(tagPerEntity, shrinkCapacity);
+	ShrinkCapacity(entityGroupMasks, shrinkCapacity);
+	ShrinkCapacity(entityIsPendingKill, shrinkCapacity);
+
+	return numEntities * (sizeof(Signature) + 3 * sizeof(int) + sizeof(GroupMask));
+}
+
+PoolStats Registry::GetTotalPoolStats() const {
+	PoolStats total;
+	for (const auto& componentPool : componentPools) {
+		if (componentPool) {
+			const PoolStats stats = componentPool->GetStats();
+			total.size += stats.size;
+			total.capacity += stats.capacity;
+			total.bytes += stats.bytes;
+		}
+	}
+	const PoolStats chunkStats = chunks.GetStats();
+	total.size += chunkStats.size;
+	total.capacity += chunkStats.capacity;
+	total.bytes += chunkStats.bytes;
+	return total;
+}
+
+void Registry::CloneInto(Registry& destination) const {
+	destination.numEntities = numEntities;
+	destination.entityGenerations = entityGenerations;
+	destination.entityComponentSignatures = entityComponentSignatures;
+	destination.entityArchetypeIds = entityArchetypeIds;
+	destination.entityArchetypeRows = entityArchetypeRows;
+	destination.entitiesWithChangedSignature = entitiesWithChangedSignature;
+	destination.entityHasChangedSignature = entityHasChangedSignature;
+	destination.entitiesToBeAdded = entitiesToBeAdded;
+	destination.entitiesToBeKilled = entitiesToBeKilled;
+	destination.entityIsPendingKill = entityIsPendingKill;
+	destination.entityIdPerTag = entityIdPerTag;
+	destination.tagPerEntity = tagPerEntity;
+	destination.groups = groups;
+	destination.entityGroupMasks = entityGroupMasks;
+	destination.freeIds = freeIds;
+	destination.tick = tick;
+
+	// Pools: copy into the pools the destination already has, clone the missing ones
+	destination.componentPools.resize(std::max(destination.componentPools.size(), componentPools.size()));
+	for (size_t componentId = 0; componentId < destination.componentPools.size(); componentId++) {
+		const IPool* pool = componentId < componentPools.size() ? componentPools[componentId].get() : nullptr;
+		auto& destinationPool = destination.componentPools[componentId];
+		if (!pool) {
+			destinationPool = nullptr;
+		}
+		else if (destinationPool) {
+			pool->CopyTo(*destinationPool);
+		}
+		else {
+			destinationPool = pool->Clone(destination.GetPoolMemoryResource(static_cast<int>(componentId)));
+			destinationPool->SetTickSource(&destination.tick);
+		}
+	}
+
+	chunks.CopyTo(destination.chunks);
+
+	// The systems cached per archetype belong to this registry, the destination matches them again on demand
+	destination.archetypes = archetypes;
+	destination.archetypeIdPerSignature = archetypeIdPerSignature;
+	for (auto& archetype : destination.archetypes) {
+		archetype.systems.clear();
+		archetype.systemsVersion = -1;
+	}
+
+	// Owning groups point to the pools of the destination
+	destination.ownedGroups.clear();
+	for (const auto& group : ownedGroups) {
+		auto destinationGroup = std::make_unique<OwnedGroup>(*group);
+		for (auto& pool : destinationGroup->pools) {
+			for (size_t componentId = 0; componentId < componentPools.size(); componentId++) {
+				if (componentPools[componentId].get() == pool) {
+					pool = destination.componentPools[componentId].get();
+					break;
+				}
+			}
+		}
+		destination.ownedGroups.push_back(std::move(destinationGroup));
+	}
+
+	// Rebind the system membership by system type, systems that only the destination has are matched again
+	for (auto& destinationSystem : destination.systems) {
+		auto system = systems.find(destinationSystem.first);
+		if (system != systems.end()) {
+			destinationSystem.second->CopySystemEntities(*system->second);
+			continue;
+		}
+		destinationSystem.second->ClearSystemEntities();
+		const auto& systemComponentSignature = destinationSystem.second->GetComponentSignature();
+		for (const auto& archetype : destination.archetypes) {
+			if (archetype.signature.ContainsAll(systemComponentSignature)) {
+				for (auto entity : archetype.entities) {
+					destinationSystem.second->AddEntityToSystem(entity);
+				}
 			}
 		}
-		groupPerEntity.erase(groupedEntity);
+	}
+
+	for (auto& commandBuffer : destination.commandBuffers) {
+		commandBuffer->Clear();
 	}
 }
 
+uint32_t Registry::GetTick() const {
+	return tick;
+}
+
+CommandBuffer& Registry::CreateCommandBuffer() {
+	commandBuffers.push_back(std::make_unique<CommandBuffer>());
+	return *commandBuffers.back();
+}
+
+EntityMap Registry::MergeFrom(Registry& source) {
+	// Flush the pending creations, kills and commands of the source, so that only its live entities are left
+	source.Update();
+
+	std::vector<bool> isSourceIdFree(source.numEntities, false);
+	for (const int entityId : source.freeIds) {
+		isSourceIdFree[entityId] = true;
+	}
+	const int numMerged = source.numEntities - static_cast<int>(source.freeIds.size());
+
+	EntityMap entityMap;
+	if (numMerged > GetNumFreeEntityIds()) {
+		Logger::Err("Cannot merge " + std::to_string(numMerged) + " entities, only " + std::to_string(GetNumFreeEntityIds()) + " ids are left");
+		return entityMap;
+	}
+	entityMap.entities.assign(source.numEntities, Entity(-1, -1));
+	entityMap.sourceGenerations.assign(source.entityGenerations.begin(), source.entityGenerations.begin() + source.numEntities);
+
+	// Give every live source entity a new id, growing the per-entity vectors once
+	const int numNewIds = numMerged - static_cast<int>(freeIds.size());
+	if (numNewIds > 0 && numEntities + numNewIds > static_cast<int>(entityComponentSignatures.size())) {
+		ResizeEntityVectors(numEntities + numNewIds);
+	}
+	entitiesToBeAdded.reserve(entitiesToBeAdded.size() + numMerged);
+	for (int sourceId = 0; sourceId < source.numEntities; sourceId++) {
+		if (isSourceIdFree[sourceId]) {
+			continue;
+		}
+		const int entityId = AllocateEntityId();
+		const Entity entity(entityId, entityGenerations[entityId]);
+		entityMap.entities[sourceId] = entity;
+		entityComponentSignatures[entityId] = source.entityComponentSignatures[sourceId];
+		entitiesToBeAdded.push_back(entity);
+	}
+
+	// Move the components one pool at a time, the component type ids are the same in every registry
+	if (source.componentPools.size() > componentPools.size()) {
+		componentPools.resize(source.componentPools.size());
+	}
+	for (size_t componentId = 0; componentId < source.componentPools.size(); componentId++) {
+		const auto& sourcePool = source.componentPools[componentId];
+		if (!sourcePool) {
+			continue;
+		}
+		auto& componentPool = componentPools[componentId];
+		if (!componentPool) {
+			componentPool = sourcePool->CreateEmpty(GetPoolMemoryResource(static_cast<int>(componentId)));
+			componentPool->SetTickSource(&tick);
+		}
+		sourcePool->MoveInto(*componentPool, entityMap);
+	}
+	source.chunks.MoveInto(chunks, entityMap);
+
+	// Tag and group ids are shared by all the registries
+	for (int sourceId = 0; sourceId < source.numEntities; sourceId++) {
+		if (isSourceIdFree[sourceId]) {
+			continue;
+		}
+		const Entity entity = entityMap.entities[sourceId];
+		const int tagId = source.tagPerEntity[sourceId];
+		if (tagId != -1) {
+			if (tagId < static_cast<int>(entityIdPerTag.size()) && entityIdPerTag[tagId] != -1) {
+				Logger::Err("Merged entity id " + std::to_string(entity.GetId()) + " takes the tag " + tagNames.GetName(tagId) +
+					" over from entity id " + std::to_string(entityIdPerTag[tagId]));
+			}
+			TagEntity(entity, tagId);
+		}
+		const auto& groupMask = source.entityGroupMasks[sourceId];
+		for (size_t groupId = 0; groupMask.any() && groupId < MAX_GROUPS; groupId++) {
+			if (groupMask.test(groupId)) {
+				GroupEntity(entity, static_cast<int>(groupId));
+			}
+		}
+	}
+
+	// Empty the source: killing its entities releases their ids and destroys the moved-from components
+	for (int sourceId = 0; sourceId < source.numEntities; sourceId++) {
+		if (!isSourceIdFree[sourceId]) {
+			source.KillEntity(Entity(sourceId, source.entityGenerations[sourceId]));
+		}
+	}
+	source.Update();
+
+	return entityMap;
+}
+
 void Registry::Update() {
-	// Add the entities that are waiting to be created to the active Systems
+	// Play back the structural changes recorded by the systems, in a deterministic order
+	for (auto& commandBuffer : commandBuffers) {
+		commandBuffer->Playback(*this);
+	}
+
+	// Add the entities that are waiting to be created to their archetype and to the active Systems
+	// Entities created together usually share a signature, so the archetype lookup is reused for the whole run
+	const Signature* lastSignature = nullptr;
+	int lastArchetypeId = -1;
 	for (auto entity : entitiesToBeAdded) {
+		const auto& signature = entityComponentSignatures[entity.GetId()];
+		if (!lastSignature || signature != *lastSignature) {
+			lastArchetypeId = GetArchetypeId(signature);
+			lastSignature = &signature;
+		}
+		AddEntityToArchetype(entity, lastArchetypeId);
 		AddEntityToSystems(entity);
+		UpdateEntityOwnedGroups(entity.GetId());
 	}
 	entitiesToBeAdded.clear();
 
+	// Re-match the live entities that gained or lost components since the last update
+	for (auto entity : entitiesWithChangedSignature) {
+		entityHasChangedSignature[entity.GetId()] = false;
+		if (IsAlive(entity)) {
+			UpdateEntitySystems(entity);
+		}
+	}
+	entitiesWithChangedSignature.clear();
+
 	// Remove the entities that are waiting to be killed from the active Systems
-	for (auto entity : entitiesToBeKilled) {
-		RemoveEntityFromSystems(entity);
+	DestroyKilledEntities();
+
+	// The entities that lost chunked components were updated or destroyed above
+	chunks.ClearPendingRemovals();
+}
+
+void Registry::DestroyKilledEntities() {
+	// Sort the kills by archetype: each run of entities shares the same systems and the same component pools
+	std::stable_sort(entitiesToBeKilled.begin(), entitiesToBeKilled.end(), [this](Entity a, Entity b) {
+		return entityArchetypeIds[a.GetId()] < entityArchetypeIds[b.GetId()];
+	});
+
+	size_t runStart = 0;
+	while (runStart < entitiesToBeKilled.size()) {
+		const int archetypeId = entityArchetypeIds[entitiesToBeKilled[runStart].GetId()];
+		size_t runEnd = runStart + 1;
+		while (runEnd < entitiesToBeKilled.size() && entityArchetypeIds[entitiesToBeKilled[runEnd].GetId()] == archetypeId) {
+			runEnd++;
+		}
+		const Entity* run = &entitiesToBeKilled[runStart];
+		const size_t runSize = runEnd - runStart;
+
+		// Entities without an archetype may be in any system or pool
+		Signature componentSignature;
+		if (archetypeId != -1) {
+			componentSignature = archetypes[archetypeId].signature;
+			for (auto system : GetArchetypeSystems(archetypeId)) {
+				for (size_t i = 0; i < runSize; i++) {
+					system->RemoveEntityFromSystem(run[i]);
+				}
+			}
+		}
+		else {
+			componentSignature.set();
+			for (auto& system : systems) {
+				for (size_t i = 0; i < runSize; i++) {
+					system.second->RemoveEntityFromSystem(run[i]);
+				}
+			}
+		}
 
-		entityComponentSignatures[entity.GetId()].reset();
+		for (size_t i = 0; i < runSize; i++) {
+			RemoveEntityFromArchetype(run[i]);
+			entityComponentSignatures[run[i].GetId()].reset();
+			if (!ownedGroups.empty()) {
+				UpdateEntityOwnedGroups(run[i].GetId());
+			}
+		}
 
-		// Remove the entity from all component pools
-		for (auto pool : componentPools) {
-			if (pool) {
-				pool->RemoveEntityFromPool(entity.GetId());
+		// Only the pools of the components of the archetype hold data for these entities
+		for (size_t componentId = 0; componentId < componentPools.size(); componentId++) {
+			if (componentSignature.test(componentId) && componentPools[componentId]) {
+				componentPools[componentId]->RemoveEntitiesFromPool(run, runSize);
 			}
 		}
+		for (size_t i = 0; i < runSize; i++) {
+			chunks.RemoveEntity(run[i].GetId());
+		}
 
-		// Make the entity id available to be reused
-		freeIds.push_back(entity.GetId());
+		for (size_t i = 0; i < runSize; i++) {
+			const Entity entity = run[i];
+
+			// Make the entity id available to be reused, with a new generation
+			entityGenerations[entity.GetId()]++;
+			freeIds.push_back(entity.GetId());
+			std::push_heap(freeIds.begin(), freeIds.end(), std::greater<int>());
+			entityIsPendingKill[entity.GetId()] = false;
+
+			RemoveEntityTag(entity);
+			RemoveEntityGroup(entity);
+		}
 
-		// Remove something about tag/group
-		RemoveEntityTag(entity);
-		RemoveEntityGroup(entity);
+		runStart = runEnd;
 	}
 	entitiesToBeKilled.clear();
 }
\ No newline at end of file
@@ -3,199 +3,2059 @@
 
 #include "../Logger/Logger.h"
 #include <bitset>
+#include <algorithm>
+#include <functional>
 #include <vector>
-#include <set>
 #include <deque>
 #include <unordered_map>
 #include <typeindex>
 #include <memory>
+#include <new>
+#include <memory_resource>
+#include <atomic>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <string>
 
 #include <iostream>
 
 
-const unsigned int MAX_COMPONENTS = 32;
+// Number of component types a signature can hold: 32, 64, 128 or 256.
+// It is chosen at build time, define ECS_MAX_COMPONENTS in the project settings to change it
+#ifndef ECS_MAX_COMPONENTS
+#define ECS_MAX_COMPONENTS 64
+#endif
+const unsigned int MAX_COMPONENTS = ECS_MAX_COMPONENTS;
+
+// Number of ids reserved for the compile time component ids (see StaticComponentId), the runtime ids stop above them.
+// It must be at least the size of the component list of the game, define ECS_STATIC_COMPONENTS to change it
+#ifndef ECS_STATIC_COMPONENTS
+#define ECS_STATIC_COMPONENTS 16
+#endif
+const int NUM_STATIC_COMPONENTS = ECS_STATIC_COMPONENTS;
+static_assert(NUM_STATIC_COMPONENTS < static_cast<int>(MAX_COMPONENTS), "ECS_STATIC_COMPONENTS leaves no id for the runtime components");
+
+// Log every component added to or removed from an entity. Off by default: a level adds thousands of components,
+// and formatting the message costs more than the add itself. Define ECS_LOG_COMPONENT_CHANGES=1 to trace them
+#ifndef ECS_LOG_COMPONENT_CHANGES
+#define ECS_LOG_COMPONENT_CHANGES 0
+#endif
+
+/// <summary>
+/// Component mask
+/// A fixed-size bit mask stored as 64-bit words, with the std::bitset interface used by the registry.
+/// Matching a signature is a few word-wide AND/compare operations, written as plain loops over the words
+/// without early exits, so the compiler can unroll and vectorize them
+/// </summary>
+template <unsigned int NumBits>
+class ComponentMask {
+	static_assert(NumBits == 32 || NumBits == 64 || NumBits == 128 || NumBits == 256, "Signatures hold 32, 64, 128 or 256 components");
+
+	private:
+		static constexpr unsigned int NUM_WORDS = (NumBits + 63) / 64;
+		uint64_t words[NUM_WORDS] = {};
+
+	public:
+		bool test(size_t bit) const {
+			return (words[bit / 64] >> (bit % 64)) & 1u;
+		}
+
+		ComponentMask& set(size_t bit, bool value = true) {
+			const uint64_t mask = uint64_t(1) << (bit % 64);
+			words[bit / 64] = value ? (words[bit / 64] | mask) : (words[bit / 64] & ~mask);
+			return *this;
+		}
+
+		ComponentMask& set() {
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				words[i] = ~uint64_t(0);
+			}
+			if (NumBits % 64 != 0) {
+				words[NUM_WORDS - 1] &= (uint64_t(1) << (NumBits % 64)) - 1;
+			}
+			return *this;
+		}
+
+		ComponentMask& reset() {
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				words[i] = 0;
+			}
+			return *this;
+		}
+
+		ComponentMask& reset(size_t bit) {
+			return set(bit, false);
+		}
+
+		bool any() const {
+			uint64_t bits = 0;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				bits |= words[i];
+			}
+			return bits != 0;
+		}
+
+		bool none() const {
+			return !any();
+		}
+
+		size_t size() const {
+			return NumBits;
+		}
+
+		// True if all the bits of other are set in this mask: (*this & other) == other
+		bool ContainsAll(const ComponentMask& other) const {
+			uint64_t missing = 0;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				missing |= other.words[i] & ~words[i];
+			}
+			return missing == 0;
+		}
+
+		// True if any bit of other is set in this mask: (*this & other).any()
+		bool Intersects(const ComponentMask& other) const {
+			uint64_t common = 0;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				common |= words[i] & other.words[i];
+			}
+			return common != 0;
+		}
+
+		ComponentMask& operator &=(const ComponentMask& other) {
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				words[i] &= other.words[i];
+			}
+			return *this;
+		}
+
+		ComponentMask& operator |=(const ComponentMask& other) {
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				words[i] |= other.words[i];
+			}
+			return *this;
+		}
+
+		ComponentMask operator &(const ComponentMask& other) const { return ComponentMask(*this) &= other; }
+		ComponentMask operator |(const ComponentMask& other) const { return ComponentMask(*this) |= other; }
+
+		bool operator ==(const ComponentMask& other) const {
+			uint64_t difference = 0;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				difference |= words[i] ^ other.words[i];
+			}
+			return difference == 0;
+		}
+
+		bool operator !=(const ComponentMask& other) const {
+			return !(*this == other);
+		}
+
+		size_t Hash() const {
+			uint64_t hash = 0;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				hash = (hash ^ words[i]) * 0x100000001b3ull;
+			}
+			return static_cast<size_t>(hash ^ (hash >> 32));
+		}
+};
+
+namespace std {
+	template <unsigned int NumBits>
+	struct hash<ComponentMask<NumBits>> {
+		size_t operator ()(const ComponentMask<NumBits>& mask) const {
+			return mask.Hash();
+		}
+	};
+}
 
 /// <summary>
 /// Signature
-/// We use bitset 1010101 to keep track of whichs components an entity has,
+/// We use a bit mask 1010101 to keep track of whichs components an entity has,
 /// and also helps keep track of which entities a system is interested in
 /// </summary>
-typedef std::bitset<MAX_COMPONENTS> Signature;
+typedef ComponentMask<MAX_COMPONENTS> Signature;
+
+/// <summary>
+/// Component ids
+/// The component types of a ComponentList get constant ids (their index in the list), so testing them
+/// in a signature is a test against a constant mask. The list is declared once for the whole game by
+/// partially specializing StaticComponentId (see Components/ComponentList.h). Every header of a listed component
+/// includes the list and asserts that its type is in it, so no translation unit sees the type without its constant id.
+/// Any other type gets a runtime id on first use, counting down from MAX_COMPONENTS - 1 to NUM_STATIC_COMPONENTS
+/// </summary>
+template <typename TComponent, typename Enable = void>
+struct StaticComponentId {
+	static constexpr int value = -1;
+};
+
+template <typename ...TComponents>
+struct ComponentList {
+	static constexpr int size = sizeof...(TComponents);
+
+	template <typename TComponent>
+	static constexpr bool Contains() {
+		return (std::is_same<TComponent, TComponents>::value || ...);
+	}
+
+	// Index of the type in the list, -1 if it is not in the list
+	template <typename TComponent>
+	static constexpr int IdOf() {
+		int id = -1;
+		int index = 0;
+		((std::is_same<TComponent, TComponents>::value && id == -1 ? (id = index, index++) : index++), ...);
+		return id;
+	}
+};
 
 struct IComponent {
 	protected :
-		// Index in Signature
-		static int nextId;
+		// Number of runtime ids given so far, atomic as registries can be filled from several threads
+		static std::atomic<int> nextId;
+
+		static int NextRuntimeId();
 };
 
 // Used to assign a unique id to a component type
 template <typename T>
 class Component : public IComponent{
 public:
-	// Returns the unique id of Component<T>
+	// Returns the unique id of Component<T>, a constant for the types of the component list
 	static int GetId() {
-		static auto id = nextId++;
-		return id;
+		if constexpr (StaticComponentId<T>::value != -1) {
+			static_assert(StaticComponentId<T>::value < NUM_STATIC_COMPONENTS, "Too many components in the list for ECS_STATIC_COMPONENTS");
+			return StaticComponentId<T>::value;
+		}
+		else {
+			static auto id = NextRuntimeId();
+			return id;
+		}
 	}
 };
 
+// Used to assign a unique id to each resource type, the index of the resource in the registry
+struct IResource {
+	protected:
+		static std::atomic<int> nextId;
+};
+
+template <typename T>
+class ResourceType : public IResource {
+	public:
+		static int GetId() {
+			static auto id = nextId++;
+			return id;
+		}
+};
+
+
+/// <summary>
+/// Entity
+/// An entity is a 32-bit handle: the low bits are the entity id (index in the registry arrays)
+/// and the high bits are a generation counter, bumped every time the id is killed and recycled.
+/// A handle that outlived its entity has an old generation, so it can be detected with IsAlive()
+/// </summary>
+const unsigned int ENTITY_ID_BITS = 20;
+const unsigned int ENTITY_GENERATION_BITS = 12;
+const uint32_t ENTITY_ID_MASK = (1u << ENTITY_ID_BITS) - 1;
+const uint32_t ENTITY_GENERATION_MASK = (1u << ENTITY_GENERATION_BITS) - 1;
+
+// The highest id is never given to an entity: Entity(-1, -1) packs to it, and stays the handle that is never alive
+const int NULL_ENTITY_ID = static_cast<int>(ENTITY_ID_MASK);
+const int MAX_ENTITIES = NULL_ENTITY_ID;
+
+// What GetComponent and GetComponentMut return for a component type (see StoragePolicy::Columns)
+template <typename TComponent, typename Enable = void>
+struct ComponentAccess;
 
 class Entity {
 	private:
-		int id;
+		uint32_t handle;
 	public:
-		Entity(int id) : id(id) {};
+		Entity(int id, int generation = 0) : 
+			handle(((static_cast<uint32_t>(generation) & ENTITY_GENERATION_MASK) << ENTITY_ID_BITS) | (static_cast<uint32_t>(id) & ENTITY_ID_MASK)) {};
 		Entity(const Entity& entity) = default;
 		void Kill();
-		int GetId() const;
+		bool IsAlive() const;
+		int GetId() const { return static_cast<int>(handle & ENTITY_ID_MASK); }
+		int GetGeneration() const { return static_cast<int>(handle >> ENTITY_ID_BITS); }
 
-		// Manage entity tags and groups
+		// Manage entity tags and groups, by name or by interned id (see Registry::GetTagId/GetGroupId)
 		void Tag(const std::string& tag);
+		void Tag(int tagId);
 		bool HasTag(const std::string& tag) const;
+		bool HasTag(int tagId) const;
 		void Group(const std::string& group);
+		void Group(int groupId);
 		bool BelongsToGroup(const std::string& group) const;
+		bool BelongsToGroup(int groupId) const;
 
 		Entity& operator =(const Entity& other) = default;
-		bool operator ==(const Entity& other) const { return id == other.id; }
-		bool operator !=(const Entity& other) const { return id != other.id; }
-		bool operator >(const Entity& other) const { return id > other.id; }
-		bool operator <(const Entity& other) const { return id < other.id; }
+		bool operator ==(const Entity& other) const { return handle == other.handle; }
+		bool operator !=(const Entity& other) const { return handle != other.handle; }
+		bool operator >(const Entity& other) const { return handle > other.handle; }
+		bool operator <(const Entity& other) const { return handle < other.handle; }
 
+		// The helper functions below forward to the current registry (see Registry::MakeCurrent)
 		template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
 		template <typename TComponent> void RemoveComponent();
 		template <typename TComponent> bool HasComponent() const;
-		template <typename TComponent> TComponent& GetComponent() const;
+		template <typename TComponent> [[nodiscard]] typename ComponentAccess<TComponent>::Reference GetComponent() const;
+		template <typename TComponent> [[nodiscard]] typename ComponentAccess<TComponent>::MutReference GetComponentMut() const;
+};
+
+// New handles of the entities of a registry that was merged into another one (see Registry::MergeFrom)
+class EntityMap {
+	private:
+		// New handle of each source entity id, and the generation the source entity had [index = source entity id]
+		std::vector<Entity> entities;
+		std::vector<int> sourceGenerations;
+
+		friend class Registry;
+
+	public:
+		// New handle of a source entity, Entity(-1, -1) if the handle was not alive in the source registry
+		Entity Map(Entity sourceEntity) const {
+			const int entityId = sourceEntity.GetId();
+			if (entityId >= static_cast<int>(sourceGenerations.size()) ||
+				static_cast<int>(sourceGenerations[entityId] & ENTITY_GENERATION_MASK) != sourceEntity.GetGeneration()) {
+				return Entity(-1, -1);
+			}
+			return entities[entityId];
+		}
+
+		// New handle of a live source entity id
+		Entity MapId(int sourceEntityId) const {
+			return entities[sourceEntityId];
+		}
+};
+
+// Components that store entity handles declare void RemapEntities(const EntityMap& entityMap), so their handles
+// follow the entities when a registry is merged into another one
+template <typename TComponent, typename = void>
+struct HasRemapEntities : std::false_type {};
+
+template <typename TComponent>
+struct HasRemapEntities<TComponent, std::void_t<decltype(std::declval<TComponent&>().RemapEntities(std::declval<const EntityMap&>()))>> : std::true_type {};
+
+/// <summary>
+/// System
+/// The System processes entities that contains a specific signature
+/// </summary>
+class System {
+	private:
+		// Which components an entity must have for the system to consider the entity
+		Signature componentSignature;     // 01010110011010
+
+		// List of all Entity that the system is interested in, always packed
+		std::vector<Entity> entities;     // tank, helicopter, pokemon..
+
+		// Position of each entity in the entities vector, -1 if the entity is not in the system
+		// [Vector index = entity id]
+		std::vector<int> entityPositions;
+
+		// Bumped every time an entity joins or leaves the system
+		uint32_t membershipVersion = 0;
+
+	public:
+		System() = default;
+		~System() = default;
+
+		void AddEntityToSystem(Entity entity);
+		void RemoveEntityFromSystem(Entity entity);
+		void ClearSystemEntities();
+
+		// Take the same entities as another system of the same type (see Registry::CloneInto)
+		void CopySystemEntities(const System& other);
+
+		const std::vector<Entity>& GetSystemEntities() const;
+		const Signature& GetComponentSignature() const;
+
+		// Compare with a version saved earlier to know if the entities of the system changed since then,
+		// even when as many entities joined as left
+		uint32_t GetMembershipVersion() const;
+
+		// Define the component type that entities must have to be considered by the system
+		template <typename TComponent> void RequireComponent();
+};
+
+
+/// <summary>
+/// Span
+/// A non-owning view over contiguous elements (a minimal std::span, which requires C++20).
+/// Used to hand out the packed component columns of the pools to the systems
+/// </summary>
+template <typename T>
+class Span {
+	private:
+		T* first;
+		size_t count;
+
+	public:
+		Span() : first(nullptr), count(0) {}
+		Span(T* first, size_t count) : first(first), count(count) {}
+
+		T* data() const { return first; }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+		T* begin() const { return first; }
+		T* end() const { return first + count; }
+
+		T& operator [](size_t index) const { return first[index]; }
+};
+
+/// <summary>
+/// Storage policy
+/// Chosen at compile time per component type, by specializing ComponentStorage:
+/// - Tag: empty types, stored only as the signature bit of the entity, with no pool at all
+/// - Sparse: rare components, packed data indexed by a compact hash map
+/// - Dense: common components, packed data indexed by a paged sparse array
+/// - Columns: hot numeric components, stored as a structure of arrays (one packed array per field) and indexed
+///   by a paged sparse array. Systems loop over the fields as column spans (see Registry::GetColumn), which
+///   the compiler can vectorize. The specialization splits the component into its fields and builds it back:
+///     static std::tuple<TFields...> ToColumns(const TComponent& component);
+///     static TComponent FromColumns(TFields... fields);
+///   GetComponent returns a copy of such a component, and GetComponentMut a handle to assign a whole component to
+/// - Chunked: components that are iterated together, stored in the chunks of the registry instead of a pool
+///   (see ChunkStorage). The entities with the same chunked components share chunks of CHUNK_SIZE bytes holding
+///   one contiguous array per component, and ViewChunks() walks them chunk by chunk.
+///   Chunked components have no change ticks, and can't be viewed, owned or sorted like the pooled ones
+/// Example: template <> struct ComponentStorage<KeyboardControlComponent> { static constexpr StoragePolicy policy = StoragePolicy::Sparse; };
+/// </summary>
+enum class StoragePolicy {
+	Tag,
+	Sparse,
+	Dense,
+	Columns,
+	Chunked
+};
+
+template <typename TComponent>
+struct ComponentStorage {
+	static constexpr StoragePolicy policy = std::is_empty<TComponent>::value ? StoragePolicy::Tag : StoragePolicy::Dense;
+};
+
+template <typename TComponent>
+constexpr bool IsTagComponent() {
+	return ComponentStorage<TComponent>::policy == StoragePolicy::Tag;
+}
+
+template <typename TComponent>
+constexpr bool IsColumnComponent() {
+	return ComponentStorage<TComponent>::policy == StoragePolicy::Columns;
+}
+
+template <typename TComponent>
+constexpr bool IsChunkedComponent() {
+	return ComponentStorage<TComponent>::policy == StoragePolicy::Chunked;
+}
+
+// Tag components carry no data, all the entities share a single instance
+template <typename TComponent>
+TComponent& GetTagInstance() {
+	static TComponent instance;
+	return instance;
+}
+
+// Number of entity ids covered by one page of the sparse array
+const int POOL_PAGE_SIZE = 1024;
+
+// Memory of a pool (or of the entity ids) is released once less than 1 / SHRINK_OCCUPANCY_RATIO of it is in use.
+// It shrinks to twice its size, so it has to empty again before the next shrink, and never below SHRINK_MIN_CAPACITY
+const int SHRINK_OCCUPANCY_RATIO = 4;
+const int SHRINK_MIN_CAPACITY = 64;
+
+// Reallocate a vector with a smaller capacity (shrink_to_fit is only a request, and can't keep any headroom)
+// The new allocation comes from the same allocator
+template <typename TVector>
+void ShrinkCapacity(TVector& vector, size_t capacity) {
+	if (vector.capacity() <= capacity || capacity < vector.size()) {
+		return;
+	}
+	TVector shrunk(vector.get_allocator());
+	shrunk.reserve(capacity);
+	shrunk.insert(shrunk.end(), std::make_move_iterator(vector.begin()), std::make_move_iterator(vector.end()));
+	vector.swap(shrunk);
+}
+
+/// <summary>
+/// Column vector
+/// The packed data of a column component: one array per field of the component, all with the same size.
+/// operator [] returns a handle to a slot, that converts to a copy of the component and that a whole component
+/// can be assigned to. GetColumn() returns the array of one field
+/// </summary>
+template <typename TFields>
+struct ColumnArrays;
+
+template <typename ...TFields>
+struct ColumnArrays<std::tuple<TFields...>> {
+	using Type = std::tuple<std::pmr::vector<TFields>...>;
+	static constexpr size_t rowBytes = (sizeof(TFields) + ... + 0);
+};
+
+template <typename T>
+class ColumnVector {
+	public:
+		// Fields of the component, in column order
+		using Fields = decltype(ComponentStorage<T>::ToColumns(std::declval<const T&>()));
+		static constexpr size_t NUM_COLUMNS = std::tuple_size<Fields>::value;
+		static constexpr size_t ROW_BYTES = ColumnArrays<Fields>::rowBytes;
+
+		template <size_t Column>
+		using FieldType = std::tuple_element_t<Column, Fields>;
+
+		static_assert(!HasRemapEntities<T>::value, "Column components can't hold entity handles");
+
+		class Reference {
+			private:
+				ColumnVector* vector;
+				size_t index;
+
+			public:
+				Reference(ColumnVector* vector, size_t index) : vector(vector), index(index) {}
+				Reference(const Reference& other) = default;
+
+				operator T() const {
+					return vector->Load(index);
+				}
+
+				Reference& operator =(const T& component) {
+					vector->Store(index, component);
+					return *this;
+				}
+
+				Reference& operator =(const Reference& other) {
+					vector->Store(index, other.vector->Load(other.index));
+					return *this;
+				}
+
+				// Exchange two slots of the same vector, one field at a time
+				void SwapWith(const Reference& other) {
+					vector->SwapRows(index, other.index);
+				}
+
+				friend void swap(Reference a, Reference b) {
+					a.SwapWith(b);
+				}
+		};
+
+	private:
+		typename ColumnArrays<Fields>::Type columns;
+
+		template <size_t ...Columns>
+		static typename ColumnArrays<Fields>::Type MakeColumns(std::pmr::memory_resource* resource, std::index_sequence<Columns...>) {
+			return typename ColumnArrays<Fields>::Type(std::pmr::vector<FieldType<Columns>>(resource)...);
+		}
+
+		template <size_t ...Columns>
+		T Load(size_t index, std::index_sequence<Columns...>) const {
+			return ComponentStorage<T>::FromColumns(std::get<Columns>(columns)[index]...);
+		}
+
+		T Load(size_t index) const {
+			return Load(index, std::make_index_sequence<NUM_COLUMNS>());
+		}
+
+		template <size_t ...Columns>
+		void Store(size_t index, const T& component, std::index_sequence<Columns...>) {
+			const Fields fields = ComponentStorage<T>::ToColumns(component);
+			((std::get<Columns>(columns)[index] = std::get<Columns>(fields)), ...);
+		}
+
+		void Store(size_t index, const T& component) {
+			Store(index, component, std::make_index_sequence<NUM_COLUMNS>());
+		}
+
+		template <size_t ...Columns>
+		void Push(const T& component, std::index_sequence<Columns...>) {
+			const Fields fields = ComponentStorage<T>::ToColumns(component);
+			(std::get<Columns>(columns).push_back(std::get<Columns>(fields)), ...);
+		}
+
+		void SwapRows(size_t indexA, size_t indexB) {
+			std::apply([indexA, indexB](auto& ...column) {
+				(std::swap(column[indexA], column[indexB]), ...);
+			}, columns);
+		}
+
+	public:
+		explicit ColumnVector(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+			columns(MakeColumns(resource, std::make_index_sequence<NUM_COLUMNS>())) {}
+
+		size_t size() const {
+			return std::get<0>(columns).size();
+		}
+
+		size_t capacity() const {
+			return std::get<0>(columns).capacity();
+		}
+
+		bool empty() const {
+			return size() == 0;
+		}
+
+		void reserve(size_t capacity) {
+			std::apply([capacity](auto& ...column) {
+				(column.reserve(capacity), ...);
+			}, columns);
+		}
+
+		void clear() {
+			std::apply([](auto& ...column) {
+				(column.clear(), ...);
+			}, columns);
+		}
+
+		template <typename ...TArgs>
+		void emplace_back(TArgs&& ...args) {
+			Push(T(std::forward<TArgs>(args)...), std::make_index_sequence<NUM_COLUMNS>());
+		}
+
+		void pop_back() {
+			std::apply([](auto& ...column) {
+				(column.pop_back(), ...);
+			}, columns);
+		}
+
+		Reference operator [](size_t index) {
+			return Reference(this, index);
+		}
+
+		T operator [](size_t index) const {
+			return Load(index);
+		}
+
+		template <size_t Column>
+		Span<FieldType<Column>> GetColumn() {
+			auto& column = std::get<Column>(columns);
+			return Span<FieldType<Column>>(column.data(), column.size());
+		}
+
+		// Reallocate every field array with a smaller capacity (see ShrinkCapacity)
+		void ShrinkTo(size_t capacity) {
+			std::apply([capacity](auto& ...column) {
+				(ShrinkCapacity(column, capacity), ...);
+			}, columns);
+		}
+};
+
+template <typename T>
+void ShrinkCapacity(ColumnVector<T>& vector, size_t capacity) {
+	vector.ShrinkTo(capacity);
+}
+
+// Components are reached by reference, except the column components: they are assembled from their fields,
+// so GetComponent returns a copy and GetComponentMut a handle to assign the whole component through.
+// The copy is const, so writing to one of its members does not compile instead of being silently lost
+template <typename TComponent, typename Enable>
+struct ComponentAccess {
+	using Reference = TComponent&;
+	using MutReference = TComponent&;
+};
+
+template <typename TComponent>
+struct ComponentAccess<TComponent, std::enable_if_t<IsColumnComponent<TComponent>()>> {
+	using Reference = const TComponent;
+	using MutReference = typename ColumnVector<TComponent>::Reference;
+};
+
+// Paged sparse array [entity id -> index in data], split in pages that are only allocated when used
+// A value of -1 means that the entity has no component in this pool
+class PagedSparseIndex {
+	private:
+		std::vector<std::unique_ptr<int[]>> pages;
+
+	public:
+		const int* Find(int entityId) const {
+			const size_t page = entityId / POOL_PAGE_SIZE;
+			if (page >= pages.size() || !pages[page]) {
+				return nullptr;
+			}
+			return &pages[page][entityId % POOL_PAGE_SIZE];
+		}
+
+		int* Find(int entityId) {
+			return const_cast<int*>(static_cast<const PagedSparseIndex*>(this)->Find(entityId));
+		}
+
+		int& Assure(int entityId) {
+			const size_t page = entityId / POOL_PAGE_SIZE;
+			if (page >= pages.size()) {
+				pages.resize(page + 1);
+			}
+			if (!pages[page]) {
+				pages[page].reset(new int[POOL_PAGE_SIZE]);
+				std::fill_n(pages[page].get(), POOL_PAGE_SIZE, -1);
+			}
+			return pages[page][entityId % POOL_PAGE_SIZE];
+		}
+
+		void Erase(int entityId) {
+			*Find(entityId) = -1;
+		}
+
+		void Clear() {
+			pages.clear();
+		}
+
+		// Release the pages past the given number of entity ids, they hold no component
+		void ShrinkTo(int numEntityIds) {
+			const size_t numPages = (numEntityIds + POOL_PAGE_SIZE - 1) / POOL_PAGE_SIZE;
+			if (pages.size() > numPages) {
+				pages.resize(numPages);
+				pages.shrink_to_fit();
+			}
+		}
+
+		size_t GetBytes() const {
+			size_t bytes = pages.capacity() * sizeof(pages[0]);
+			for (const auto& page : pages) {
+				bytes += page ? POOL_PAGE_SIZE * sizeof(int) : 0;
+			}
+			return bytes;
+		}
+
+		// Copy the pages into another index, reusing the pages it already has
+		void CopyTo(PagedSparseIndex& destination) const {
+			destination.pages.resize(pages.size());
+			for (size_t page = 0; page < pages.size(); page++) {
+				if (!pages[page]) {
+					destination.pages[page].reset();
+					continue;
+				}
+				if (!destination.pages[page]) {
+					destination.pages[page].reset(new int[POOL_PAGE_SIZE]);
+				}
+				std::memcpy(destination.pages[page].get(), pages[page].get(), POOL_PAGE_SIZE * sizeof(int));
+			}
+		}
+};
+
+// Hashed map [entity id -> index in data], that only takes memory for the entities that have the component
+class HashedSparseIndex {
+	private:
+		std::unordered_map<int, int> indices;
+
+	public:
+		const int* Find(int entityId) const {
+			auto index = indices.find(entityId);
+			return index != indices.end() ? &index->second : nullptr;
+		}
+
+		int* Find(int entityId) {
+			auto index = indices.find(entityId);
+			return index != indices.end() ? &index->second : nullptr;
+		}
+
+		int& Assure(int entityId) {
+			return indices.emplace(entityId, -1).first->second;
+		}
+
+		void Erase(int entityId) {
+			indices.erase(entityId);
+		}
+
+		void Clear() {
+			indices.clear();
+		}
+
+		void ShrinkTo(int) {
+			indices.rehash(0);
+		}
+
+		// Approximate, the node layout depends on the standard library
+		size_t GetBytes() const {
+			return indices.size() * (sizeof(std::pair<const int, int>) + sizeof(void*)) + indices.bucket_count() * sizeof(void*);
+		}
+
+		void CopyTo(HashedSparseIndex& destination) const {
+			destination.indices = indices;
+		}
+};
+
+/// <summary>
+/// Pool
+/// A pool is a sparse set of objects of type T:
+/// the component data is kept in a packed vector (continous data),
+/// and a sparse index (paged array or hash map, see StoragePolicy) maps each entity id to its index in that vector.
+/// Every slot also keeps the tick at which its component was added and last changed
+/// </summary>
+
+// Memory use of a component pool, for monitoring
+struct PoolStats {
+	int size = 0;        // number of components
+	int capacity = 0;    // number of components that fit before the packed data grows
+	size_t bytes = 0;    // memory held by the packed data and the sparse index
+};
+
+class IPool {
+	protected:
+		// Change counter of the registry, incremented every time a component is added or changed
+		uint32_t* tick = nullptr;
+
+		uint32_t NextTick() {
+			return tick ? ++(*tick) : 0;
+		}
+
+	public:
+		virtual ~IPool() = default;
+		virtual void RemoveEntityFromPool(int entityId) = 0;
+		virtual void RemoveEntitiesFromPool(const Entity* entities, size_t count) = 0;
+		virtual int IndexOf(int entityId) const = 0;
+		virtual void Swap(int indexA, int indexB) = 0;
+
+		// Ticks of the component of an entity, 0 if the entity has no component in this pool
+		virtual uint32_t GetAddedTick(int entityId) const = 0;
+		virtual uint32_t GetChangedTick(int entityId) const = 0;
+
+		void SetTickSource(uint32_t* tick) {
+			this->tick = tick;
+		}
+
+		// Copy the whole pool into a pool of the same component type, reusing its allocations
+		virtual void CopyTo(IPool& destination) const = 0;
+		virtual std::shared_ptr<IPool> Clone(std::pmr::memory_resource* resource) const = 0;
+
+		virtual PoolStats GetStats() const = 0;
+
+		// An empty pool of the same component type
+		virtual std::shared_ptr<IPool> CreateEmpty(std::pmr::memory_resource* resource) const = 0;
+
+		// Move all the components into a pool of the same type, under the entity ids of the entity map.
+		// The moved-from components stay in this pool until their entities are removed
+		virtual void MoveInto(IPool& destination, const EntityMap& entityMap) = 0;
+
+		// Bytes that Shrink() would move, 0 if the pool has no memory worth releasing
+		virtual size_t GetShrinkCost() const = 0;
+		virtual void Shrink() = 0;
+};
+
+template <typename T>
+class Pool:public IPool {
+	private:
+		// Packed component data, one array per field for the column components, and the entity id that owns each slot
+		// The packed vectors allocate from the memory resource of the pool (see Registry::SetMemoryResource)
+		typename std::conditional<IsColumnComponent<T>(), ColumnVector<T>, std::pmr::vector<T>>::type data;
+		std::pmr::vector<int> entityIds;
+
+		// Tick at which each component was added, and last changed [index = index in data]
+		std::pmr::vector<uint32_t> addedTicks;
+		std::pmr::vector<uint32_t> changedTicks;
+
+		// Scratch permutation of SortBy, kept between sorts to reuse its memory
+		std::vector<int> sortOrder;
+
+		// Expected number of components (see Registry::ReserveComponents), the pool never shrinks below it
+		int capacityHint = 0;
+
+		// Capacity the packed data can shrink to, or its current capacity if it is still occupied enough
+		size_t GetShrinkCapacity() const {
+			const size_t capacity = data.capacity();
+			if (capacity <= static_cast<size_t>(SHRINK_MIN_CAPACITY) || data.size() * SHRINK_OCCUPANCY_RATIO >= capacity) {
+				return capacity;
+			}
+			const size_t shrinkCapacity = std::max({ data.size() * 2, static_cast<size_t>(capacityHint), static_cast<size_t>(SHRINK_MIN_CAPACITY) });
+			return std::min(shrinkCapacity, capacity);
+		}
+
+		// Sparse index [entity id -> index in data]
+		typename std::conditional<ComponentStorage<T>::policy == StoragePolicy::Sparse, HashedSparseIndex, PagedSparseIndex>::type sparseIndex;
+
+		// Bytes of packed data per component
+		static constexpr size_t GetDataBytesPerComponent() {
+			if constexpr (IsColumnComponent<T>()) {
+				return ColumnVector<T>::ROW_BYTES;
+			}
+			else {
+				return sizeof(T);
+			}
+		}
+
+	public:
+		// Reference to a component in the packed data, for a column component a handle to its slot (see ColumnVector)
+		using Reference = decltype(data[0]);
+
+		Pool(int capacity = 0, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+			data(resource), entityIds(resource), addedTicks(resource), changedTicks(resource) {
+			Reserve(capacity);
+		}
+		virtual ~Pool() = default;
+
+		bool IsEmpty() const {
+			return data.empty();
+		}
+
+		int GetSize() const {
+			return static_cast<int>(data.size());
+		}
+
+		void Reserve(int n) {
+			data.reserve(n);
+			entityIds.reserve(n);
+			addedTicks.reserve(n);
+			changedTicks.reserve(n);
+		}
+
+		// Reserve room for the expected number of components, and keep it when the pool shrinks
+		void SetCapacityHint(int capacity) {
+			capacityHint = capacity;
+			Reserve(capacity);
+		}
+
+		void Clear() {
+			data.clear();
+			entityIds.clear();
+			addedTicks.clear();
+			changedTicks.clear();
+			sparseIndex.Clear();
+		}
+
+		bool Contains(int entityId) const {
+			const int* slot = sparseIndex.Find(entityId);
+			return slot && *slot != -1;
+		}
+
+		// Returns the index of the entity component in the packed data, or -1 if there is none
+		int IndexOf(int entityId) const override {
+			const int* slot = sparseIndex.Find(entityId);
+			return slot ? *slot : -1;
+		}
+
+		// Construct the component of an entity in place from the given constructor arguments
+		template <typename ...TArgs>
+		Reference Emplace(int entityId, TArgs&& ...args) {
+			int& index = sparseIndex.Assure(entityId);
+			const uint32_t currentTick = NextTick();
+			if (index != -1) {
+				// if the element already exists, simply replace the componet object
+				data[index] = T(std::forward<TArgs>(args)...);
+				changedTicks[index] = currentTick;
+			}
+			else {
+				// Construct the new object directly in the unused capacity at the end of the packed data
+				index = GetSize();
+				data.emplace_back(std::forward<TArgs>(args)...);
+				entityIds.push_back(entityId);
+				addedTicks.push_back(currentTick);
+				changedTicks.push_back(currentTick);
+			}
+			return data[index];
+		}
+
+		void Set(int entityId, const T& object) {
+			Emplace(entityId, object);
+		}
+
+		void Set(int entityId, T&& object) {
+			Emplace(entityId, std::move(object));
+		}
+
+		void Remove(int entityId) {
+			int* slotOfRemoved = sparseIndex.Find(entityId);
+			if (!slotOfRemoved || *slotOfRemoved == -1) {
+				return;
+			}
+
+			// move the last element to the deleted position to keep the array packed
+			int& indexOfRemoved = *slotOfRemoved;
+			const int indexOfLast = GetSize() - 1;
+			const int entityIdOfLastElement = entityIds[indexOfLast];
+
+			if (indexOfRemoved != indexOfLast) {
+				data[indexOfRemoved] = std::move(data[indexOfLast]);
+				entityIds[indexOfRemoved] = entityIdOfLastElement;
+				addedTicks[indexOfRemoved] = addedTicks[indexOfLast];
+				changedTicks[indexOfRemoved] = changedTicks[indexOfLast];
+				sparseIndex.Assure(entityIdOfLastElement) = indexOfRemoved;
+			}
+			sparseIndex.Erase(entityId);
+
+			data.pop_back();
+			entityIds.pop_back();
+			addedTicks.pop_back();
+			changedTicks.pop_back();
+		}
+
+		// Exchange two slots of the packed data, used to keep the pools of an owning group aligned
+		void Swap(int indexA, int indexB) override {
+			if (indexA == indexB) {
+				return;
+			}
+			using std::swap;
+			swap(data[indexA], data[indexB]);
+			std::swap(entityIds[indexA], entityIds[indexB]);
+			std::swap(addedTicks[indexA], addedTicks[indexB]);
+			std::swap(changedTicks[indexA], changedTicks[indexB]);
+			sparseIndex.Assure(entityIds[indexA]) = indexA;
+			sparseIndex.Assure(entityIds[indexB]) = indexB;
+		}
+
+		// Sort the packed data with compare(const T& a, const T& b), the entity ids and ticks follow their component.
+		// The order is kept until components are added or removed, or the pool is sorted again (the sort is not stable)
+		template <typename TCompare>
+		void SortBy(TCompare compare) {
+			const int size = GetSize();
+			sortOrder.resize(size);
+			for (int i = 0; i < size; i++) {
+				sortOrder[i] = i;
+			}
+			std::sort(sortOrder.begin(), sortOrder.end(), [this, &compare](int a, int b) {
+				return compare(data[a], data[b]);
+			});
+
+			// Apply the permutation in place, walking each cycle: slot i takes the component at sortOrder[i]
+			for (int i = 0; i < size; i++) {
+				int current = i;
+				int next = sortOrder[i];
+				while (next != i) {
+					Swap(current, next);
+					sortOrder[current] = current;
+					current = next;
+					next = sortOrder[next];
+				}
+				sortOrder[current] = current;
+			}
+		}
+
+		// Restore the order of a pool that was sorted with the same comparator, moving only the components that are
+		// out of place: the ones whose key changed, the ones added since the last sort, and the ones moved by a removal.
+		// This is an insertion sort, so it is linear (and does nothing) when the pool is still in order, and it is stable
+		template <typename TCompare>
+		void SortByIncremental(TCompare compare) {
+			const int size = GetSize();
+			for (int i = 1; i < size; i++) {
+				for (int j = i; j > 0 && compare(data[j], data[j - 1]); j--) {
+					Swap(j - 1, j);
+				}
+			}
+		}
+
+		void RemoveEntityFromPool(int entityId) override {
+			if (Contains(entityId)) {
+				Remove(entityId);
+			}
+		}
+
+		// Remove a batch of entities with a single virtual call, the entities that have no component are skipped
+		void RemoveEntitiesFromPool(const Entity* entities, size_t count) override {
+			for (size_t i = 0; i < count; i++) {
+				Remove(entities[i].GetId());
+			}
+		}
+
+		Reference Get(int entityId) {
+			return data[*sparseIndex.Find(entityId)];
+		}
+
+		// Get the component of an entity to modify it, stamping it as changed
+		Reference GetMut(int entityId) {
+			const int index = *sparseIndex.Find(entityId);
+			changedTicks[index] = NextTick();
+			return data[index];
+		}
+
+		uint32_t GetAddedTick(int entityId) const override {
+			const int index = IndexOf(entityId);
+			return index != -1 ? addedTicks[index] : 0;
+		}
+
+		uint32_t GetChangedTick(int entityId) const override {
+			const int index = IndexOf(entityId);
+			return index != -1 ? changedTicks[index] : 0;
+		}
+
+		int GetEntityId(unsigned int index) const {
+			return entityIds[index];
+		}
+
+		// Set the same object for many entities, growing the packed data only once
+		void SetMany(const std::vector<Entity>& entities, const T& object) {
+			const size_t requiredSize = data.size() + entities.size();
+			if (requiredSize > data.capacity()) {
+				Reserve(static_cast<int>(std::max(requiredSize, data.capacity() * 2)));
+			}
+			for (auto entity : entities) {
+				Set(entity.GetId(), object);
+			}
+		}
+
+		const std::pmr::vector<int>& GetEntityIds() const {
+			return entityIds;
+		}
+
+		// The packed component data, and in the same order the entity id that owns each component
+		Span<T> GetComponents() {
+			static_assert(!IsColumnComponent<T>(), "Column components are stored one field per array, use GetColumn");
+			return Span<T>(data.data(), data.size());
+		}
+
+		// One field of all the components of a column component, in the same order as the entity ids
+		template <size_t Column>
+		auto GetColumn() {
+			static_assert(IsColumnComponent<T>(), "Only the column components are stored one field per array");
+			return data.template GetColumn<Column>();
+		}
+
+		Span<const int> GetComponentEntityIds() const {
+			return Span<const int>(entityIds.data(), entityIds.size());
+		}
+
+		Reference operator [](unsigned int index) {
+			return data[index];
+		}
+
+		// The vector assignments reuse the destination capacity, and are plain memory copies for trivially copyable types
+		void CopyTo(IPool& destination) const override {
+			auto& destinationPool = static_cast<Pool<T>&>(destination);
+			destinationPool.data = data;
+			destinationPool.entityIds = entityIds;
+			destinationPool.addedTicks = addedTicks;
+			destinationPool.changedTicks = changedTicks;
+			destinationPool.capacityHint = capacityHint;
+			sparseIndex.CopyTo(destinationPool.sparseIndex);
+		}
+
+		std::shared_ptr<IPool> Clone(std::pmr::memory_resource* resource) const override {
+			std::shared_ptr<Pool<T>> clone = std::make_shared<Pool<T>>(0, resource);
+			CopyTo(*clone);
+			return clone;
+		}
+
+		std::shared_ptr<IPool> CreateEmpty(std::pmr::memory_resource* resource) const override {
+			std::shared_ptr<Pool<T>> pool = std::make_shared<Pool<T>>(0, resource);
+			pool->capacityHint = capacityHint;
+			return pool;
+		}
+
+		// The destination keeps the larger capacity hint, so a pool sized for a loaded level doesn't shrink below it
+		void MoveInto(IPool& destination, const EntityMap& entityMap) override {
+			auto& destinationPool = static_cast<Pool<T>&>(destination);
+			destinationPool.capacityHint = std::max(destinationPool.capacityHint, capacityHint);
+			destinationPool.Reserve(std::max(destinationPool.GetSize() + GetSize(), destinationPool.capacityHint));
+			for (int i = 0; i < GetSize(); i++) {
+				if constexpr (HasRemapEntities<T>::value) {
+					data[i].RemapEntities(entityMap);
+				}
+				destinationPool.Emplace(entityMap.MapId(entityIds[i]).GetId(), std::move(data[i]));
+			}
+		}
+
+		PoolStats GetStats() const override {
+			PoolStats stats;
+			stats.size = GetSize();
+			stats.capacity = static_cast<int>(data.capacity());
+			stats.bytes = data.capacity() * GetDataBytesPerComponent() + entityIds.capacity() * sizeof(int) +
+				(addedTicks.capacity() + changedTicks.capacity()) * sizeof(uint32_t) + sortOrder.capacity() * sizeof(int) +
+				sparseIndex.GetBytes();
+			return stats;
+		}
+
+		size_t GetShrinkCost() const override {
+			return GetShrinkCapacity() < data.capacity() ? data.size() * (GetDataBytesPerComponent() + sizeof(int) + 2 * sizeof(uint32_t)) : 0;
+		}
+
+		// Move the packed data to smaller allocations, and release the sparse pages past the last entity of the pool
+		void Shrink() override {
+			const size_t capacity = GetShrinkCapacity();
+			if (capacity >= data.capacity()) {
+				return;
+			}
+			ShrinkCapacity(data, capacity);
+			ShrinkCapacity(entityIds, capacity);
+			ShrinkCapacity(addedTicks, capacity);
+			ShrinkCapacity(changedTicks, capacity);
+			sortOrder.clear();
+			sortOrder.shrink_to_fit();
+
+			int maxEntityId = -1;
+			for (const int entityId : entityIds) {
+				maxEntityId = std::max(maxEntityId, entityId);
+			}
+			sparseIndex.ShrinkTo(maxEntityId + 1);
+		}
+};
+
+/// <summary>
+/// View
+/// A view iterates all the entities that have a given set of components, without copying any entity list.
+/// It walks the smallest of the required pools and hands out references to all the requested components.
+/// Example: registry->View<SpriteComponent, HealthComponent>(Without<ProjectileComponent>())
+///              .Each([](Entity entity, SpriteComponent& sprite, HealthComponent& health) { ... });
+/// Column components are handed out as const copies, write them back through GetComponentMut:
+///     registry->View<TransformComponent, RigidBodyComponent>()
+///         .Each([&](Entity entity, const TransformComponent transform, const RigidBodyComponent rigidbody) {
+///             registry->GetComponentMut<TransformComponent>(entity) = TransformComponent(transform.position + rigidbody.velocity, transform.scale);
+///         });
+/// Changed<T>(tick) and Added<T>(tick) filters keep only the entities whose component was changed or added after a tick:
+///     registry->View<HealthComponent>(Without<>(), Changed<HealthComponent>(lastTick))
+/// Entities must not be added to or removed from the viewed pools while iterating
+/// </summary>
+
+// Excludes the entities that have any of the given components from a view
+template <typename ...TComponents>
+struct Without {};
+
+// Requests a component that the entity may not have, the view passes a pointer that is null when it is missing
+template <typename TComponent>
+struct Optional {};
+
+// Keeps only the entities whose component was changed (or added) after the given tick, see Registry::GetTick()
+template <typename TComponent>
+struct Changed {
+	using Type = TComponent;
+	static constexpr bool isAdded = false;
+	uint32_t sinceTick;
+
+	explicit Changed(uint32_t sinceTick) : sinceTick(sinceTick) {}
+};
+
+// Keeps only the entities whose component was added after the given tick
+template <typename TComponent>
+struct Added {
+	using Type = TComponent;
+	static constexpr bool isAdded = true;
+	uint32_t sinceTick;
+
+	explicit Added(uint32_t sinceTick) : sinceTick(sinceTick) {}
+};
+
+const int MAX_VIEW_TICK_FILTERS = 4;
+
+struct TickFilter {
+	const IPool* pool;
+	bool isAdded;
+	uint32_t sinceTick;
+
+	bool Matches(int entityId) const {
+		return (isAdded ? pool->GetAddedTick(entityId) : pool->GetChangedTick(entityId)) > sinceTick;
+	}
+};
+
+template <typename TComponent>
+struct ViewComponent {
+	using Type = TComponent;
+	using Reference = typename ComponentAccess<TComponent>::Reference;
+	static constexpr bool isOptional = false;
+};
+
+template <typename TComponent>
+struct ViewComponent<Optional<TComponent>> {
+	using Type = TComponent;
+	using Reference = TComponent*;
+	static constexpr bool isOptional = true;
+};
+
+template <typename ...TComponents>
+class ComponentView {
+	private:
+		std::tuple<Pool<typename ViewComponent<TComponents>::Type>*...> pools;
+		const std::vector<Signature>* entityComponentSignatures;
+		const std::vector<int>* entityGenerations;
+		Signature requiredSignature;
+		Signature excludedSignature;
+
+		// Changed/Added filters of the view
+		TickFilter tickFilters[MAX_VIEW_TICK_FILTERS];
+		int numTickFilters = 0;
+
+		// Entity ids of the smallest required pool, null when a required pool does not exist
+		// (a view needs at least one required component that is not a tag)
+		const std::pmr::vector<int>* candidates = nullptr;
+
+		// Tag components have no pool, they are only checked in the signature
+		template <typename TViewComponent>
+		void SelectCandidates(bool& hasAllPools) {
+			if constexpr (!ViewComponent<TViewComponent>::isOptional && !IsTagComponent<typename ViewComponent<TViewComponent>::Type>()) {
+				auto pool = std::get<Pool<typename ViewComponent<TViewComponent>::Type>*>(pools);
+				if (!pool) {
+					hasAllPools = false;
+				}
+				else if (!candidates || pool->GetSize() < static_cast<int>(candidates->size())) {
+					candidates = &pool->GetEntityIds();
+				}
+			}
+		}
+
+		bool Matches(int entityId) const {
+			const auto& signature = (*entityComponentSignatures)[entityId];
+			if (!signature.ContainsAll(requiredSignature) || signature.Intersects(excludedSignature)) {
+				return false;
+			}
+			for (int i = 0; i < numTickFilters; i++) {
+				if (!tickFilters[i].Matches(entityId)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		template <typename TViewComponent>
+		typename ViewComponent<TViewComponent>::Reference Fetch(int entityId) const {
+			using TComponent = typename ViewComponent<TViewComponent>::Type;
+			auto pool = std::get<Pool<TComponent>*>(pools);
+			if constexpr (IsTagComponent<TComponent>() && ViewComponent<TViewComponent>::isOptional) {
+				return (*entityComponentSignatures)[entityId].test(Component<TComponent>::GetId()) ? &GetTagInstance<TComponent>() : nullptr;
+			}
+			else if constexpr (IsTagComponent<TComponent>()) {
+				return GetTagInstance<TComponent>();
+			}
+			else if constexpr (ViewComponent<TViewComponent>::isOptional) {
+				static_assert(!IsColumnComponent<TComponent>(), "Column components have no address, they can't be optional in a view");
+				return pool && pool->Contains(entityId) ? &pool->Get(entityId) : nullptr;
+			}
+			else {
+				return pool->Get(entityId);
+			}
+		}
+
+	public:
+		ComponentView(Pool<typename ViewComponent<TComponents>::Type>* ...pools, 
+					  const std::vector<Signature>& entityComponentSignatures, const std::vector<int>& entityGenerations, 
+					  const Signature& requiredSignature, const Signature& excludedSignature) :
+			pools(pools...), entityComponentSignatures(&entityComponentSignatures), entityGenerations(&entityGenerations),
+			requiredSignature(requiredSignature), excludedSignature(excludedSignature) {
+			bool hasAllPools = true;
+			(SelectCandidates<TComponents>(hasAllPools), ...);
+			if (!hasAllPools) {
+				candidates = nullptr;
+			}
+		}
+
+		// Keep only the entities whose component in the pool was changed/added after sinceTick
+		void AddTickFilter(const IPool* pool, bool isAdded, uint32_t sinceTick) {
+			if (!pool) {
+				// No entity ever had the component
+				candidates = nullptr;
+				return;
+			}
+			tickFilters[numTickFilters++] = TickFilter{ pool, isAdded, sinceTick };
+		}
+
+		// Forward iterator over the entities of the view
+		class Iterator {
+			private:
+				const ComponentView* view;
+				size_t position;
+
+				void SkipUnmatched() {
+					while (position < view->candidates->size() && !view->Matches((*view->candidates)[position])) {
+						position++;
+					}
+				}
+
+			public:
+				Iterator(const ComponentView* view, size_t position) : view(view), position(position) {
+					if (view->candidates) {
+						SkipUnmatched();
+					}
+				}
+
+				Entity operator *() const {
+					const int entityId = (*view->candidates)[position];
+					return Entity(entityId, (*view->entityGenerations)[entityId]);
+				}
+
+				Iterator& operator ++() {
+					position++;
+					SkipUnmatched();
+					return *this;
+				}
+
+				bool operator ==(const Iterator& other) const { return position == other.position; }
+				bool operator !=(const Iterator& other) const { return position != other.position; }
+		};
+
+		Iterator begin() const {
+			return Iterator(this, 0);
+		}
+
+		Iterator end() const {
+			return Iterator(this, candidates ? candidates->size() : 0);
+		}
+
+		// Get one of the viewed components of an entity returned by the view
+		template <typename TComponent>
+		typename ComponentAccess<TComponent>::Reference Get(Entity entity) const {
+			if constexpr (IsTagComponent<TComponent>()) {
+				return GetTagInstance<TComponent>();
+			}
+			else {
+				return std::get<Pool<TComponent>*>(pools)->Get(entity.GetId());
+			}
+		}
+
+		// Call func(entity, components...) for every entity of the view
+		template <typename TFunc>
+		void Each(TFunc func) const {
+			if (!candidates) {
+				return;
+			}
+			for (const int entityId : *candidates) {
+				if (Matches(entityId)) {
+					func(Entity(entityId, (*entityGenerations)[entityId]), Fetch<TComponents>(entityId)...);
+				}
+			}
+		}
+};
+
+/// <summary>
+/// Owning group
+/// An owning group takes over the order of the pools of its components: the first N slots
+/// of every owned pool belong to the same N entities, in the same order.
+/// Iterating the group is a lockstep walk over aligned arrays, with no sparse lookup at all.
+/// Example: const auto group = registry->OwnGroup<TransformComponent, RigidBodyComponent>();
+///          float* positionX = group.GetColumn<TransformComponent, TransformComponent::PositionX>().data();
+///          const float* velocityX = group.GetColumn<RigidBodyComponent, RigidBodyComponent::VelocityX>().data();
+///          for (int i = 0; i < group.GetSize(); i++) { positionX[i] += velocityX[i] * deltaTime; }
+/// Each() hands out references to the other components, and const copies of the column components
+/// A pool can only be owned by one group. Entities join and leave the group in Registry::Update()
+/// </summary>
+struct OwnedGroup {
+	// Components owned by the group, and their pools
+	Signature signature;
+	std::vector<IPool*> pools;
+
+	// Number of entities in the group, they take the first slots of every owned pool
+	int size = 0;
+
+	bool Contains(int entityId) const {
+		const int index = pools[0]->IndexOf(entityId);
+		return index != -1 && index < size;
+	}
+};
+
+template <typename ...TComponents>
+class OwningGroup {
+	private:
+		std::tuple<Pool<TComponents>*...> pools;
+		const OwnedGroup* group;
+		const std::vector<int>* entityGenerations;
+
+		// What Each() indexes for a component: its packed data, or the pool of a column component
+		template <typename TComponent>
+		auto GetRows() const {
+			if constexpr (IsColumnComponent<TComponent>()) {
+				return std::get<Pool<TComponent>*>(pools);
+			}
+			else {
+				return std::get<Pool<TComponent>*>(pools)->GetComponents().data();
+			}
+		}
+
+		template <typename TComponent, typename TRows>
+		static typename ComponentAccess<TComponent>::Reference GetRow(TRows rows, int index) {
+			if constexpr (IsColumnComponent<TComponent>()) {
+				return (*rows)[index];
+			}
+			else {
+				return rows[index];
+			}
+		}
+
+		template <typename TFunc, size_t ...Indices>
+		void Each(TFunc& func, std::index_sequence<Indices...>) const {
+			const int size = GetSize();
+			const int* entityIds = GetEntityIds().data();
+			auto rows = std::make_tuple(GetRows<TComponents>()...);
+			for (int i = 0; i < size; i++) {
+				const int entityId = entityIds[i];
+				func(Entity(entityId, (*entityGenerations)[entityId]), GetRow<TComponents>(std::get<Indices>(rows), i)...);
+			}
+		}
+
+	public:
+		OwningGroup(Pool<TComponents>* ...pools, const OwnedGroup* group, const std::vector<int>& entityGenerations) :
+			pools(pools...), group(group), entityGenerations(&entityGenerations) {}
+
+		int GetSize() const {
+			return group ? group->size : 0;
+		}
+
+		// Aligned columns: index i of every column belongs to the same entity
+		template <typename TComponent>
+		Span<TComponent> GetComponents() const {
+			if (!group) {
+				return Span<TComponent>();
+			}
+			return Span<TComponent>(std::get<Pool<TComponent>*>(pools)->GetComponents().data(), GetSize());
+		}
+
+		// One field of a column component, aligned with the other columns of the group
+		template <typename TComponent, size_t Column>
+		auto GetColumn() const {
+			using TColumn = decltype(std::declval<Pool<TComponent>&>().template GetColumn<Column>());
+			if (!group) {
+				return TColumn();
+			}
+			return TColumn(std::get<Pool<TComponent>*>(pools)->template GetColumn<Column>().data(), GetSize());
+		}
+
+		Span<const int> GetEntityIds() const {
+			if (!group) {
+				return Span<const int>();
+			}
+			return Span<const int>(std::get<0>(pools)->GetComponentEntityIds().data(), GetSize());
+		}
+
+		// Call func(entity, components...) for every entity of the group
+		template <typename TFunc>
+		void Each(TFunc func) const {
+			if (GetSize() == 0) {
+				return;
+			}
+			Each(func, std::index_sequence_for<TComponents...>());
+		}
+};
+
+/// <summary>
+/// Chunk storage
+/// Storage of the chunked components (see StoragePolicy::Chunked), shared by all of them in a registry.
+/// The entities that have the same set of chunked components form a chunk archetype, whose rows are packed in chunks
+/// of CHUNK_SIZE bytes: a chunk holds the entity ids of its rows, then one contiguous column per component.
+/// Adding or removing a chunked component moves the row of the entity to the archetype of its new set of components,
+/// and the last row of the old archetype fills the hole. ChunkedView walks the matching archetypes chunk by chunk
+/// </summary>
+
+// Bytes of a chunk (a chunk is bigger if a single row doesn't fit), every column of a chunk starts on a cache line
+const size_t CHUNK_SIZE = 16 * 1024;
+const size_t CHUNK_ALIGNMENT = 64;
+
+// How the chunk storage moves, copies and destroys a component that it only knows by its id
+struct ChunkComponentType {
+	size_t size = 0;
+	size_t alignment = 0;
+	void (*moveConstruct)(void* destination, void* source) = nullptr;
+	void (*copyConstruct)(void* destination, const void* source) = nullptr;
+	void (*destroy)(void* component) = nullptr;
+
+	// Null for the components that store no entity handles (see HasRemapEntities)
+	void (*remapEntities)(void* component, const EntityMap& entityMap) = nullptr;
+
+	template <typename TComponent>
+	static ChunkComponentType Of() {
+		ChunkComponentType type;
+		type.size = sizeof(TComponent);
+		type.alignment = alignof(TComponent);
+		type.moveConstruct = [](void* destination, void* source) {
+			new (destination) TComponent(std::move(*static_cast<TComponent*>(source)));
+		};
+		type.copyConstruct = [](void* destination, const void* source) {
+			new (destination) TComponent(*static_cast<const TComponent*>(source));
+		};
+		type.destroy = [](void* component) {
+			static_cast<TComponent*>(component)->~TComponent();
+		};
+		if constexpr (HasRemapEntities<TComponent>::value) {
+			type.remapEntities = [](void* component, const EntityMap& entityMap) {
+				static_cast<TComponent*>(component)->RemapEntities(entityMap);
+			};
+		}
+		return type;
+	}
+};
+
+// All the entities that have exactly the same chunked components
+struct ChunkArchetype {
+	Signature signature;
+
+	// Components of the archetype in column order (ascending component ids), where their column starts in a chunk,
+	// and the size of one component
+	std::vector<int> componentIds;
+	std::vector<size_t> columnOffsets;
+	std::vector<size_t> componentSizes;
+
+	// Column of each component [index = component id], -1 if the archetype doesn't have the component
+	std::vector<int> columnPerComponent;
+
+	// Rows that fit in a chunk, and bytes of a chunk
+	int chunkCapacity = 0;
+	size_t chunkBytes = 0;
+
+	// Chunks of the archetype, all full except the last ones [row = chunk index * chunkCapacity + index in the chunk]
+	std::vector<unsigned char*> chunks;
+	int size = 0;
+
+	int GetNumUsedChunks() const {
+		return (size + chunkCapacity - 1) / chunkCapacity;
+	}
+
+	int GetChunkSize(int chunk) const {
+		return std::min(chunkCapacity, size - chunk * chunkCapacity);
+	}
+
+	int* GetEntityIds(int chunk) const {
+		return reinterpret_cast<int*>(chunks[chunk]);
+	}
+
+	int& GetEntityId(int row) const {
+		return GetEntityIds(row / chunkCapacity)[row % chunkCapacity];
+	}
+
+	unsigned char* GetColumn(int chunk, int column) const {
+		return chunks[chunk] + columnOffsets[column];
+	}
+
+	void* GetComponent(int row, int column) const {
+		return GetColumn(row / chunkCapacity, column) + (row % chunkCapacity) * componentSizes[column];
+	}
+};
+
+class ChunkStorage {
+	private:
+		// Chunks are allocated from the memory resource of the registry (see Registry::SetMemoryResource)
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+
+		// Type of every chunked component stored so far [index = component id]
+		std::vector<ChunkComponentType> componentTypes;
+
+		// [Vector index = chunk archetype id]
+		std::vector<ChunkArchetype> archetypes;
+		std::unordered_map<Signature, int> archetypeIdPerSignature;
+
+		// Chunk archetype and row of each entity, -1 when it has no chunked component [index = entity id]
+		std::vector<int> entityArchetypeIds;
+		std::vector<int> entityRows;
+
+		// Components removed from entities that are already in their systems, whose rows are only moved
+		// in the next Registry::Update(): until then, the views have to check the signature of every row
+		int numPendingRemovals = 0;
+
+		// The component types of the signature must already be known
+		int GetArchetypeId(const Signature& signature);
+
+		void AssureEntity(int entityId);
+
+		// Append a row for an entity, its components are left for the caller to construct
+		int AppendRow(int archetypeId, int entityId);
+
+		// Destroy the components of a row, and move the last row of the archetype into it
+		void RemoveRow(int archetypeId, int row);
+
+		// Move the row of an entity to the archetype of the given components: the components it keeps are moved,
+		// the ones it loses are destroyed, and the ones it gains are left for the caller to construct
+		void MoveEntity(int entityId, const Signature& signature);
+
+		void* GetComponent(int entityId, int componentId) const {
+			const auto& archetype = archetypes[entityArchetypeIds[entityId]];
+			return archetype.GetComponent(entityRows[entityId], archetype.columnPerComponent[componentId]);
+		}
+
+	public:
+		ChunkStorage() = default;
+		ChunkStorage(const ChunkStorage&) = delete;
+		ChunkStorage& operator =(const ChunkStorage&) = delete;
+		~ChunkStorage();
+
+		// The resource can only be changed while no chunk is allocated
+		void SetMemoryResource(std::pmr::memory_resource* resource);
+		bool HasChunks() const;
+
+		// Construct the component of an entity from the given constructor arguments, or replace the one it has
+		template <typename TComponent, typename ...TArgs>
+		void Emplace(int entityId, TArgs&& ...args) {
+			const int componentId = Component<TComponent>::GetId();
+			if (componentId >= static_cast<int>(componentTypes.size())) {
+				componentTypes.resize(componentId + 1);
+			}
+			if (!componentTypes[componentId].destroy) {
+				componentTypes[componentId] = ChunkComponentType::Of<TComponent>();
+			}
+			AssureEntity(entityId);
+
+			// Built before the row moves, the arguments may point into it
+			TComponent component(std::forward<TArgs>(args)...);
+			if (Has(entityId, componentId)) {
+				Get<TComponent>(entityId) = std::move(component);
+				return;
+			}
+
+			Signature signature;
+			if (entityArchetypeIds[entityId] != -1) {
+				signature = archetypes[entityArchetypeIds[entityId]].signature;
+			}
+			signature.set(componentId);
+			MoveEntity(entityId, signature);
+			new (GetComponent(entityId, componentId)) TComponent(std::move(component));
+		}
+
+		template <typename TComponent>
+		TComponent& Get(int entityId) const {
+			return *static_cast<TComponent*>(GetComponent(entityId, Component<TComponent>::GetId()));
+		}
+
+		bool Has(int entityId, int componentId) const;
+		void Remove(int entityId, int componentId);
+
+		// Destroy the chunked components of an entity that are not in the given signature
+		void RemoveMissing(int entityId, const Signature& signature);
+
+		// Deferred removals (see Registry::RemoveComponent), all applied by the end of Registry::Update()
+		void AddPendingRemoval() { numPendingRemovals++; }
+		void ClearPendingRemovals() { numPendingRemovals = 0; }
+		bool HasPendingRemovals() const { return numPendingRemovals > 0; }
+
+		void RemoveEntity(int entityId);
+		void Clear();
+
+		// Copy all the chunks into another storage, replacing its content
+		void CopyTo(ChunkStorage& destination) const;
+
+		// Move all the components into another storage, under the entity ids of the entity map.
+		// The moved-from components stay in this storage until their entities are removed
+		void MoveInto(ChunkStorage& destination, const EntityMap& entityMap);
+
+		// Every archetype keeps one empty chunk to refill, release them
+		void ReleaseSpareChunks();
+
+		PoolStats GetStats() const;
+		const std::vector<ChunkArchetype>& GetArchetypes() const;
+};
+
+/// <summary>
+/// Chunked view
+/// Iterates the entities that have a set of chunked components, one chunk at a time: each chunk hands out the ids of
+/// its entities and one packed array per component, all of the same size.
+/// Example: registry->ViewChunks<PositionComponent, VelocityComponent>()
+///              .EachChunk([](Span<const int> entityIds, Span<PositionComponent> positions, Span<VelocityComponent> velocities) { ... });
+/// Chunked components must not be added to or removed from the viewed entities while iterating (use a command buffer).
+/// A component removed from an entity that is in its systems keeps its row until the next Update(): until then
+/// the view skips the rows whose entity lost one of the components, and hands out the chunk in several runs
+/// </summary>
+template <typename ...TComponents>
+class ChunkedView {
+	private:
+		const ChunkStorage* storage;
+		const std::vector<int>* entityGenerations;
+		const std::vector<Signature>* entityComponentSignatures;
+		Signature requiredSignature;
+
+		template <typename TComponent>
+		static Span<TComponent> GetColumn(const ChunkArchetype& archetype, int chunk) {
+			const int column = archetype.columnPerComponent[Component<TComponent>::GetId()];
+			return Span<TComponent>(reinterpret_cast<TComponent*>(archetype.GetColumn(chunk, column)), archetype.GetChunkSize(chunk));
+		}
+
+	public:
+		// Call func for each run of rows of a chunk whose entities still have all the components
+		template <typename TFunc>
+		void EachRun(TFunc& func, Span<const int> entityIds, Span<TComponents> ...columns) const {
+			const size_t size = entityIds.size();
+			size_t runStart = 0;
+			while (runStart < size) {
+				while (runStart < size && !(*entityComponentSignatures)[entityIds[runStart]].ContainsAll(requiredSignature)) {
+					runStart++;
+				}
+				size_t runEnd = runStart;
+				while (runEnd < size && (*entityComponentSignatures)[entityIds[runEnd]].ContainsAll(requiredSignature)) {
+					runEnd++;
+				}
+				if (runEnd > runStart) {
+					const size_t runSize = runEnd - runStart;
+					func(Span<const int>(entityIds.data() + runStart, runSize), Span<TComponents>(columns.data() + runStart, runSize)...);
+				}
+				runStart = runEnd;
+			}
+		}
+
+	public:
+		ChunkedView(const ChunkStorage& storage, const std::vector<int>& entityGenerations, const std::vector<Signature>& entityComponentSignatures) :
+			storage(&storage), entityGenerations(&entityGenerations), entityComponentSignatures(&entityComponentSignatures) {
+			(requiredSignature.set(Component<TComponents>::GetId()), ...);
+		}
+
+		// Call func(entityIds, components...) for every chunk of the matching archetypes, with one span per component
+		template <typename TFunc>
+		void EachChunk(TFunc func) const {
+			for (const auto& archetype : storage->GetArchetypes()) {
+				if (!archetype.signature.ContainsAll(requiredSignature)) {
+					continue;
+				}
+				const int numChunks = archetype.GetNumUsedChunks();
+				const bool checkRows = storage->HasPendingRemovals();
+				for (int chunk = 0; chunk < numChunks; chunk++) {
+					const Span<const int> entityIds(archetype.GetEntityIds(chunk), archetype.GetChunkSize(chunk));
+					if (checkRows) {
+						EachRun(func, entityIds, GetColumn<TComponents>(archetype, chunk)...);
+					}
+					else {
+						func(entityIds, GetColumn<TComponents>(archetype, chunk)...);
+					}
+				}
+			}
+		}
+
+		// Call func(entity, components...) for every matching entity, in chunk order
+		template <typename TFunc>
+		void Each(TFunc func) const {
+			EachChunk([this, &func](Span<const int> entityIds, Span<TComponents> ...columns) {
+				for (size_t i = 0; i < entityIds.size(); i++) {
+					const int entityId = entityIds[i];
+					func(Entity(entityId, (*entityGenerations)[entityId]), columns[i]...);
+				}
+			});
+		}
+};
+
+/// <summary>
+/// Tags and groups
+/// Tag and group names are interned once into small integer ids, shared by all the registries.
+/// Systems can look the ids up once and then test them without hashing or comparing strings.
+/// Group membership is a bitmask per entity, so an entity can belong to up to MAX_GROUPS groups
+/// </summary>
+const unsigned int MAX_GROUPS = 32;
+typedef std::bitset<MAX_GROUPS> GroupMask;
+
+class NameTable {
+	private:
+		// Names are interned from any thread: a deque keeps the returned names in place as it grows
+		mutable std::mutex mutex;
+		std::unordered_map<std::string, int> idPerName;
+		std::deque<std::string> names;
+
+	public:
+		// Returns the id of a name, interning it the first time it is seen
+		int GetId(const std::string& name);
+
+		// Returns the id of a name, or -1 if it was never interned
+		int FindId(const std::string& name) const;
+
+		const std::string& GetName(int id) const;
+};
+
+// Dense list of the members of a group, and the position of each member in that list
+struct EntityGroup {
+	std::vector<Entity> entities;
+	std::vector<int> entityPositions;
+};
+
+/// <summary>
+/// Prefab
+/// A prefab is the blueprint of an entity: a set of pre-built components and a group.
+/// Registry::Instantiate copies the prefab component rows straight into the pools,
+/// so the components don't need to be constructed again for every new entity
+/// </summary>
+class IPrefabComponent {
+	public:
+		virtual ~IPrefabComponent() = default;
+		virtual int GetComponentId() const = 0;
+		virtual void CopyTo(class Registry& registry, int entityId) const = 0;
+};
+
+template <typename TComponent>
+class PrefabComponent : public IPrefabComponent {
+	public:
+		TComponent component;
+
+		template <typename ...TArgs>
+		PrefabComponent(TArgs&& ...args) : component(std::forward<TArgs>(args)...) {}
+
+		int GetComponentId() const override {
+			return Component<TComponent>::GetId();
+		}
+
+		void CopyTo(class Registry& registry, int entityId) const override;
+};
+
+class Prefab {
+	private:
+		Signature componentSignature;
+		int groupId = -1;
+		std::vector<std::unique_ptr<IPrefabComponent>> components;
+
+	public:
+		Prefab() = default;
+
+		template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
+
+		void Group(const std::string& group);
+		int GetGroupId() const { return groupId; }
+
+		const Signature& GetComponentSignature() const { return componentSignature; }
+		const std::vector<std::unique_ptr<IPrefabComponent>>& GetComponents() const { return components; }
+};
+
+/// <summary>
+/// Command buffer
+/// A command buffer records structural changes (create, add/remove component, kill) instead of applying them,
+/// so a system can run off the main thread as long as it only touches its own buffer.
+/// The commands are constructed back to back in blocks of memory that are reused from frame to frame,
+/// and all the buffers of a registry are played back in their creation order at the start of Registry::Update().
+/// Entities created by a buffer only exist after the playback, until then they are referred to by a PendingEntity
+/// </summary>
+
+// Size and alignment of the memory blocks the commands are recorded into
+// Commands with a stricter alignment, or bigger than a block, get a block of their own
+const size_t COMMAND_BLOCK_SIZE = 4096;
+const size_t COMMAND_BLOCK_ALIGNMENT = 64;
+
+// Entity created by a command buffer, that doesn't exist yet in the registry
+struct PendingEntity {
+	int index;
+};
+
+// Entity targeted by a command: an existing entity, or one created earlier by the same buffer
+struct CommandTarget {
+	Entity entity;
+	int pendingIndex;
+
+	CommandTarget(Entity entity) : entity(entity), pendingIndex(-1) {}
+	CommandTarget(PendingEntity pendingEntity) : entity(-1, -1), pendingIndex(pendingEntity.index) {}
+
+	Entity Resolve(const std::vector<Entity>& createdEntities) const {
+		return pendingIndex == -1 ? entity : createdEntities[pendingIndex];
+	}
+};
+
+class ICommand {
+	public:
+		virtual ~ICommand() = default;
+		virtual void Execute(class Registry& registry, std::vector<Entity>& createdEntities) = 0;
+};
+
+class CreateEntityCommand : public ICommand {
+	private:
+		int pendingIndex;
 
-		// Hold a pointer to the entity's owner registry
-		class Registry* registry;
+	public:
+		CreateEntityCommand(int pendingIndex) : pendingIndex(pendingIndex) {}
+		void Execute(class Registry& registry, std::vector<Entity>& createdEntities) override;
 };
 
-/// <summary>
-/// System
-/// The System processes entities that contains a specific signature
-/// </summary>
-class System {
+template <typename ...TOverrides>
+class InstantiateCommand : public ICommand {
 	private:
-		// Which components an entity must have for the system to consider the entity
-		Signature componentSignature;     // 01010110011010
-
-		// List of all Entity that the system is interested in 
-		std::vector<Entity> entities;     // tank, helicopter, pokemon..
+		int pendingIndex;
+		const Prefab* prefab;
+		std::tuple<TOverrides...> overrides;
 
 	public:
-		System() = default;
-		~System() = default;
+		template <typename ...TArgs>
+		InstantiateCommand(int pendingIndex, const Prefab& prefab, TArgs&& ...overrides) :
+			pendingIndex(pendingIndex), prefab(&prefab), overrides(std::forward<TArgs>(overrides)...) {}
+		void Execute(class Registry& registry, std::vector<Entity>& createdEntities) override;
+};
 
-		void AddEntityToSystem(Entity entity);
-		void RemoveEntityFromSystem(Entity entity);
-		std::vector<Entity> GetSystemEntities() const;
-		const Signature& GetComponentSignature() const;
+template <typename TComponent>
+class AddComponentCommand : public ICommand {
+	private:
+		CommandTarget target;
+		TComponent component;
 
-		// Define the component type that entities must have to be considered by the system
-		template <typename TComponent> void RequireComponent();
+	public:
+		template <typename ...TArgs>
+		AddComponentCommand(CommandTarget target, TArgs&& ...args) : target(target), component(std::forward<TArgs>(args)...) {}
+		void Execute(class Registry& registry, std::vector<Entity>& createdEntities) override;
 };
 
+template <typename TComponent>
+class RemoveComponentCommand : public ICommand {
+	private:
+		CommandTarget target;
 
-/// <summary>
-/// Pool
-/// A pool is just a vector (continous data) of objects of type T
-/// </summary>
+	public:
+		RemoveComponentCommand(CommandTarget target) : target(target) {}
+		void Execute(class Registry& registry, std::vector<Entity>& createdEntities) override;
+};
+
+class KillEntityCommand : public ICommand {
+	private:
+		CommandTarget target;
 
-class IPool {
 	public:
-		virtual ~IPool() = default;
-		virtual void RemoveEntityFromPool(int entityId) = 0;
+		KillEntityCommand(CommandTarget target) : target(target) {}
+		void Execute(class Registry& registry, std::vector<Entity>& createdEntities) override;
 };
 
-template <typename T>
-class Pool:public IPool {
+class CommandBuffer {
 	private:
-		std::vector<T> data;
-		int size;
+		// Frees a block with the alignment it was allocated with
+		struct AlignedBlockDelete {
+			size_t alignment;
+			void operator ()(unsigned char* block) const {
+				::operator delete[](block, std::align_val_t(alignment));
+			}
+		};
 
-		// Keep track of entity ids per index, so the vector is always packed
-		std::unordered_map<int, int> entityIdToIndex;
-		std::unordered_map<int, int> indexToEntityId;
+		// Memory blocks the commands are constructed in, kept when the buffer is cleared
+		std::vector<std::unique_ptr<unsigned char[], AlignedBlockDelete>> blocks;
+		std::vector<size_t> blockSizes;
+		size_t currentBlock = 0;
+		size_t blockOffset = 0;
 
-	public:
-		Pool(int capacity = 100) {
-			size = 0;
-			data.resize(capacity);
-		}
-		virtual ~Pool() = default;
+		// Recorded commands, in recording order
+		std::vector<ICommand*> commands;
 
-		bool IsEmpty() const {
-			return size == 0;
-		}
+		// Number of entities created by the recorded commands, and the real entities once they are played back
+		int numPendingEntities = 0;
+		std::vector<Entity> createdEntities;
 
-		int GetSize() const {
-			return size;
-		}
+		void* Allocate(size_t size, size_t alignment);
 
-		void Resize(int n) {
-			data.resize(n);
+		template <typename TCommand, typename ...TArgs>
+		void Record(TArgs&& ...args) {
+			void* memory = Allocate(sizeof(TCommand), alignof(TCommand));
+			commands.push_back(new (memory) TCommand(std::forward<TArgs>(args)...));
 		}
 
-		void Clear() {
-			data.clear();
-			size = 0;
+	public:
+		CommandBuffer() = default;
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator =(const CommandBuffer&) = delete;
+		~CommandBuffer() {
+			Clear();
 		}
 
-		void Add(T object) {
-			data.push_back(object);
+		bool IsEmpty() const {
+			return commands.empty();
 		}
 
-		void Set(int entityId, T object) {
-			if (entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
-				// if the element already exists, simply replace the componet object
-				int index = entityIdToIndex[entityId];
-				data[index] = object;
-			}
-			else {
-				// Adding a new object 
-				int index = size;
-				entityIdToIndex.emplace(entityId, index);
-				indexToEntityId.emplace(index, entityId);
-				if (index >= data.capacity()) {
-					// Resize data
-					data.resize(size * 2);
-				}
-				data[index] = object;
-				size++;
-			}
+		PendingEntity CreateEntity();
+		void KillEntity(CommandTarget target);
+
+		// The prefab must outlive the playback of the buffer
+		template <typename ...TOverrides>
+		PendingEntity Instantiate(const Prefab& prefab, TOverrides&& ...overrides) {
+			const int pendingIndex = numPendingEntities++;
+			Record<InstantiateCommand<std::decay_t<TOverrides>...>>(pendingIndex, prefab, std::forward<TOverrides>(overrides)...);
+			return PendingEntity{ pendingIndex };
 		}
 
-		void Remove(int entityId) {
-			// copy the last element to the deleted position to keep the array packed
-			int indexOfRemoved = entityIdToIndex[entityId];
-			int indexOfLast = size - 1;
-			data[indexOfRemoved] = data[indexOfLast];
+		// The component is constructed when it is recorded, and moved into its pool on playback
+		template <typename TComponent, typename ...TArgs>
+		void AddComponent(CommandTarget target, TArgs&& ...args) {
+			Record<AddComponentCommand<TComponent>>(target, std::forward<TArgs>(args)...);
+		}
 
-			// Update the index-entity maps to point to the correct elements
-			int entityIdOfLastElement = indexToEntityId[indexOfLast];
-			entityIdToIndex[entityIdOfLastElement] = indexOfRemoved;
-			indexToEntityId[indexOfRemoved] = entityIdOfLastElement;
+		template <typename TComponent>
+		void RemoveComponent(CommandTarget target) {
+			Record<RemoveComponentCommand<TComponent>>(target);
+		}
 
-			entityIdToIndex.erase(entityId);
-			indexToEntityId.erase(indexOfLast);
+		// Apply all the recorded commands to the registry, in recording order, and clear the buffer
+		void Playback(class Registry& registry);
+		void Clear();
+};
 
-			size--;
-		}
+/// <summary>
+/// Archetype
+/// An archetype groups all the entities that share the same component signature,
+/// so entities with identical components can be found and processed together as a batch
+/// </summary>
+struct Archetype {
+	Signature signature;
 
-		void RemoveEntityFromPool(int entityId) override {
-			if (entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
-				Remove(entityId);
-			}
-		}
+	// Packed list of the entities that have exactly this signature
+	std::vector<Entity> entities;
 
-		T& Get(int entityId) {
-			int index = entityIdToIndex[entityId];
-			return static_cast<T&>(data[index]);
-		}
+	// Systems interested in this signature, rebuilt when the registry systems change
+	std::vector<System*> systems;
+	int systemsVersion = -1;
 
-		T& operator [](unsigned int index) {
-			return data[index];
-		}
+	Archetype(const Signature& signature) : signature(signature) {}
 };
 
 /// <summary>
@@ -214,37 +2074,143 @@ private:
 	// Pool index == entity id
 	std::vector<std::shared_ptr<IPool>> componentPools;
 
+	// Chunks of the chunked components, which have no pool (see StoragePolicy::Chunked)
+	ChunkStorage chunks;
+
+	// Generation of each entity id, incremented when the entity is killed
+	// [Vector index = entity id]
+	std::vector<int> entityGenerations;
+
 	// Vector of component signatures per entity, saying which component is turned "on" for a given entity
 	// [Vector index = entity id]
 	std::vector<Signature> entityComponentSignatures;
 
+	// Archetypes of the entities that were already added to the systems
+	// [Vector index = archetype id]
+	std::vector<Archetype> archetypes;
+	std::unordered_map<Signature, int> archetypeIdPerSignature;
+
+	// Archetype id and row inside that archetype, per entity (-1 when not in an archetype)
+	// [Vector index = entity id]
+	std::vector<int> entityArchetypeIds;
+	std::vector<int> entityArchetypeRows;
+
 	// Map of active system [ index = system id ]
 	std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
 
-	// Set of entities that are flagged to be added or removed in the next Update()
-	std::set<Entity> entitiesToBeAdded;
-	std::set<Entity> entitiesToBeKilled;
+	// Entities already added to the systems whose components changed since the last Update()
+	std::vector<Entity> entitiesWithChangedSignature;
+	std::vector<bool> entityHasChangedSignature;
+
+	// Owning groups declared with OwnGroup()
+	std::vector<std::unique_ptr<OwnedGroup>> ownedGroups;
+
+	// Change counter, incremented every time a component is added or changed (see Pool ticks)
+	uint32_t tick = 0;
+
+	// Incremented when a system is added or removed, invalidates the systems cached per archetype
+	int systemsVersion = 0;
+
+	// Resources of the registry, one instance of each type [index = resource type id]
+	std::vector<std::shared_ptr<void>> resources;
+
+	// Command buffers, played back in creation order at the start of Update()
+	std::vector<std::unique_ptr<CommandBuffer>> commandBuffers;
+
+	// Entities that are flagged to be added or removed in the next Update()
+	std::vector<Entity> entitiesToBeAdded;
+	// Kills are processed in batches of entities that share an archetype
+	std::vector<Entity> entitiesToBeKilled;
+	std::vector<bool> entityIsPendingKill;
+
+	// Entity Tags (one tag per entity, one entity per tag)
+	// [entityIdPerTag index = tag id, -1 when untagged] [tagPerEntity index = entity id, -1 when untagged]
+	std::vector<int> entityIdPerTag;
+	std::vector<int> tagPerEntity;
 
-	// Entity Tags (one tag per entity)
-	std::unordered_map<std::string, Entity> entityPerTag;
-	std::unordered_map<int, std::string> tagPerEntity;
+	// Entity groups: the members of each group [index = group id], and the groups of each entity [index = entity id]
+	std::vector<EntityGroup> groups;
+	std::vector<GroupMask> entityGroupMasks;
 
-	// Entity groups (a set of entities per group)
-	std::unordered_map<std::string, std::set<Entity>> entitiesPerGroup;
-	std::unordered_map<int, std::string> groupPerEntity;
+	// Tag and group names interned for all the registries
+	static NameTable tagNames;
+	static NameTable groupNames;
 
-	// List of free entity ids that were previously removed
-	std::deque<int> freeIds;
+	// Free entity ids that were previously removed, a min-heap so the lowest ids are reused first:
+	// the id space stays dense and the highest ids can be released (see Shrink)
+	std::vector<int> freeIds;
+
+	// Component pool where the next Shrink() call resumes
+	size_t shrinkCursor = 0;
+
+	// Memory resource the pools allocate from, and the ones set for specific components [index = component type id]
+	std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource();
+	std::vector<std::pmr::memory_resource*> componentMemoryResources;
+
+	std::pmr::memory_resource* GetPoolMemoryResource(int componentId) const;
+
+	// Registry used by the Entity helper functions on the current thread
+	static thread_local Registry* current;
+
+	// Returns the pool of a component type, or null if no entity ever had that component
+	template <typename TComponent> Pool<TComponent>* GetPool() const;
+	template <typename TComponent> Pool<TComponent>* AssurePool();
+
+	// Store a component of an entity in its pool or its chunk, tag components only live in the signature
+	template <typename TComponent, typename ...TArgs> void EmplaceComponent(int entityId, TArgs&& ...args);
+
+	template <typename TComponent> friend class PrefabComponent;
+
+	// Returns -1 when all the MAX_ENTITIES ids are in use
+	int AllocateEntityId();
+	int GetNumFreeEntityIds() const;
+	void ResizeEntityVectors(int numEntityIds);
+
+	// Release the free ids at the end of the id space and the per-entity memory past them, returns the bytes moved
+	size_t ShrinkEntityVectors();
+
+	// Destroy the entities waiting to be killed, one archetype at a time
+	void DestroyKilledEntities();
+
+	// Move an entity in or out of the owning groups, to match its current signature
+	void UpdateEntityOwnedGroups(int entityId);
+
+	// Whether the pool of a component is owned by a group
+	bool IsPoolOwned(int componentId) const;
 
 public:
 	Registry() {
+		if (!current) {
+			current = this;
+		}
 		Logger::Log("Registry constructer called");
 	}
 
 	~Registry() {
+		if (current == this) {
+			current = nullptr;
+		}
 		Logger::Log("Registry destructer called");
 	}
 
+	// Access the registry that the Entity helpers of the current thread are working with
+	static Registry* GetCurrent();
+	void MakeCurrent();
+
+	// Makes a registry current on this thread until the end of a scope, then restores the one that was current before,
+	// so a worker thread doesn't keep a pointer to a registry that it handed over.
+	// A registry that is already current (the first one built on a thread is) is not current anymore after the scope
+	class CurrentScope {
+		private:
+			Registry* previous;
+
+		public:
+			explicit CurrentScope(Registry& registry) : previous(current != &registry ? current : nullptr) { current = &registry; }
+			~CurrentScope() { current = previous; }
+			CurrentScope(const CurrentScope&) = delete;
+			CurrentScope& operator =(const CurrentScope&) = delete;
+	};
+
 	// The registry Update() finally processes the entities that are waiting to be added/ killed
 	void Update();
 
@@ -252,23 +2218,110 @@ public:
 	Entity CreateEntity();
 	void KillEntity(Entity entity);
 
+	// Kill whole sets of entities at once, e.g. for level teardown
+	void KillGroup(const std::string& group);
+	void KillGroup(int groupId);
+	template <typename TComponent> void KillAllWith();
+
+	// Bulk entity creation, without any logging: all the entities are added to their systems in the next Update()
+	// A count of zero or less creates nothing and returns an empty vector
+	std::vector<Entity> CreateEntities(int count);
+	template <typename ...TComponents> std::vector<Entity> CreateEntities(int count, const TComponents& ...components);
+	bool IsAlive(Entity entity) const;
+	// Handle of the entity currently using an id, e.g. one read from GetComponentEntityIds()
+	Entity GetEntity(int entityId) const;
+
+	// Interned tag and group ids, they can be cached and used in place of the names
+	static int GetTagId(const std::string& tag);
+	static int GetGroupId(const std::string& group);
+
 	// Tag Management
 	void TagEntity(Entity entity, const std::string& tag);
+	void TagEntity(Entity entity, int tagId);
 	bool EntityHasTag(Entity enitty, const std::string& tag) const;
+	bool EntityHasTag(Entity entity, int tagId) const;
 	Entity GetEntityByTag(const std::string& tag) const;
+	Entity GetEntityByTag(int tagId) const;
 	void RemoveEntityTag(Entity entity);
 
 	// Group Management
 	void GroupEntity(Entity entity, const std::string& group);
+	void GroupEntity(Entity entity, int groupId);
 	bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
-	std::vector<Entity> GetEntitiesByGroup(const std::string& tag) const;
+	bool EntityBelongsToGroup(Entity entity, int groupId) const;
+	Span<const Entity> GetEntitiesByGroup(const std::string& group) const;
+	Span<const Entity> GetEntitiesByGroup(int groupId) const;
+	void RemoveEntityFromGroup(Entity entity, int groupId);
 	void RemoveEntityGroup(Entity entity);
 
 	// Component management
 	template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
 	template <typename TComponent> void RemoveComponent(Entity entity);
 	template <typename TComponent> bool HasComponent(Entity entity) const;
-	template <typename TComponent> TComponent& GetComponent(Entity entity) const;
+	// A column component is returned as a const copy: a change to it is not stored, use GetComponentMut to write it back
+	template <typename TComponent> [[nodiscard]] typename ComponentAccess<TComponent>::Reference GetComponent(Entity entity) const;
+
+	// Get a component to modify it, it is stamped as changed for the Changed<T> view filter
+	// For a column component this is a handle that a whole component is assigned to
+	template <typename TComponent> [[nodiscard]] typename ComponentAccess<TComponent>::MutReference GetComponentMut(Entity entity);
+
+	// Current value of the change counter: a system can keep it and later only look at what changed after it
+	uint32_t GetTick() const;
+
+	// Memory management: reserve room for the expected number of entities and components of a level (the pools keep
+	// that room when they shrink), and release memory once a pool (or the id space) is mostly empty.
+	// Shrink moves at most about byteBudget bytes per call, picking up where the previous call stopped
+	void ReserveEntities(int count);
+	template <typename TComponent> void ReserveComponents(int count);
+
+	// Memory resource the component pools allocate from, for all components or for one component type
+	// (see ECS/MemoryResources.h, or use any std::pmr resource). A resource must be set before the pools it
+	// applies to are created, and must outlive the registry
+	void SetMemoryResource(std::pmr::memory_resource* resource);
+	template <typename TComponent> void SetComponentMemoryResource(std::pmr::memory_resource* resource);
+	void Shrink(size_t byteBudget);
+
+	// Memory use of the pool of a component, and of all the pools together
+	template <typename TComponent> PoolStats GetPoolStats() const;
+	PoolStats GetTotalPoolStats() const;
+
+	// Packed column of all the components of a type, and the id of the entity that owns each of them
+	// Loops over these columns are plain linear walks, with no per-entity lookup
+	template <typename TComponent> Span<TComponent> GetComponents() const;
+	template <typename TComponent> Span<const int> GetComponentEntityIds() const;
+
+	// One field of all the components of a column component, e.g. GetColumn<TransformComponent, TransformComponent::PositionX>()
+	template <typename TComponent, size_t Column> auto GetColumn() const;
+
+	// Sort the packed column of a component, so GetComponents() walks it in that order. SortComponentsIncremental
+	// keeps a sorted column in order every frame, only moving the components that are out of place.
+	// The pools owned by a group are ordered by their group and cannot be sorted
+	template <typename TComponent, typename TCompare> void SortComponents(TCompare compare);
+	template <typename TComponent, typename TCompare> void SortComponentsIncremental(TCompare compare);
+
+	// Create an entity from a prefab, the override components replace (or are added to) the prefab ones
+	template <typename ...TOverrides> Entity Instantiate(const Prefab& prefab, TOverrides&& ...overrides);
+
+	// Resources are objects the registry owns a single instance of (map bounds, camera, frame time...), shared by all
+	// the systems. Resource<T>() creates a default one on first access, SetResource<T>() creates or replaces it
+	template <typename TResource> TResource& Resource();
+	template <typename TResource, typename ...TArgs> TResource& SetResource(TArgs&& ...args);
+	template <typename TResource> bool HasResource() const;
+	template <typename TResource> void RemoveResource();
+
+	// Create a command buffer to record structural changes from a system, it lives as long as the registry.
+	// Buffers must be created from the main thread, each one can then be filled by a single thread at a time
+	CommandBuffer& CreateCommandBuffer();
+
+	// Iterate the entities that have all TComponents (and none of the excluded ones), the filters are Changed<T>/Added<T>
+	template <typename ...TComponents, typename ...TExcluded, typename ...TFilters> 
+	ComponentView<TComponents...> View(Without<TExcluded...> excluded = {}, TFilters ...filters) const;
+
+	// Iterate the entities that have all the chunked TComponents, one chunk at a time
+	template <typename ...TComponents> ChunkedView<TComponents...> ViewChunks() const;
+
+	// Declare (or get) the owning group of TComponents, the first call packs the existing entities of the group
+	template <typename ...TComponents> OwningGroup<TComponents...> OwnGroup();
 
 	// System management
 	template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
@@ -281,6 +2334,33 @@ public:
 	void AddEntityToSystems(Entity entiy);
 	void RemoveEntityFromSystems(Entity entity);
 
+	// Archetype management
+	int GetArchetypeId(const Signature& signature);
+	void AddEntityToArchetype(Entity entity, int archetypeId);
+	void RemoveEntityFromArchetype(Entity entity);
+	const std::vector<System*>& GetArchetypeSystems(int archetypeId);
+
+	// Copy the whole state of the registry (entities, components, archetypes, tags, groups) into another registry,
+	// reusing the allocations the destination already has. The systems of the destination get the same entities
+	// as the matching systems of this registry, their own state is left untouched.
+	// Command buffers are not copied: the pending commands of the destination are dropped.
+	// Resources are not copied either, the destination keeps its own
+	void CloneInto(Registry& destination) const;
+
+	// Move all the entities of another registry into this one in bulk, so a level (or a large spawn) can be built
+	// in a staging registry on a worker thread, then merged at a frame boundary on the main thread.
+	// The entities get new ids and join their archetypes and systems in the next Update(); the returned map gives
+	// their new handles, and the components with a RemapEntities member remap the handles they store.
+	// A tag names a single entity: a merged entity takes its tag over from the entity of this registry that had it,
+	// and the collision is logged as an error.
+	// The source registry is left empty, no other thread may use it during the merge
+	EntityMap MergeFrom(Registry& source);
+
+	// Queue a live entity to be moved to the archetype and systems matching its new signature
+	void OnSignatureChanged(Entity entity);
+	void UpdateEntitySystems(Entity entity);
+	const std::vector<Archetype>& GetArchetypes() const;
+
 };
 
 //// System //////////////////
@@ -294,12 +2374,14 @@ template <typename TSystem, typename ...TArgs>
 void Registry::AddSystem(TArgs&& ...args) {
 	std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
 	systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+	systemsVersion++;
 }
 
 template <typename TSystem> 
 void Registry::RemoveSystem() {
 	auto system = systems.find(std::type_index(typeid(TSystem)));
 	systems.erase(system);
+	systemsVersion++;
 }
 
 template <typename TSystem> 
@@ -318,31 +2400,152 @@ TSystem& Registry::GetSystem() const {
 
 // Registry
 ///////////////////////////////////////////////////////
-template <typename TComponent, typename ...TArgs>
-void Registry::AddComponent(Entity entity, TArgs&& ...args) {
+template <typename TComponent>
+Pool<TComponent>* Registry::AssurePool() {
 	const auto componentId = Component<TComponent>::GetId();
-	const auto entityId = entity.GetId();
 
-	if (componentId >= componentPools.size()) {
+	if (static_cast<size_t>(componentId) >= componentPools.size()) {
 		componentPools.resize(componentId + 1, nullptr);
 	}
 
 	if (!componentPools[componentId]) {
-		std::shared_ptr<Pool<TComponent>> newComponentPool(new Pool<TComponent>());
+		std::shared_ptr<Pool<TComponent>> newComponentPool(new Pool<TComponent>(0, GetPoolMemoryResource(componentId)));
+		newComponentPool->SetTickSource(&tick);
 		componentPools[componentId] = newComponentPool;
 	}
 
-	std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+	return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename TComponent, typename ...TArgs>
+void Registry::EmplaceComponent(int entityId, TArgs&& ...args) {
+	if constexpr (IsChunkedComponent<TComponent>()) {
+		chunks.Emplace<TComponent>(entityId, std::forward<TArgs>(args)...);
+	}
+	else if constexpr (!IsTagComponent<TComponent>()) {
+		AssurePool<TComponent>()->Emplace(entityId, std::forward<TArgs>(args)...);
+	}
+}
+
+template <typename ...TComponents>
+std::vector<Entity> Registry::CreateEntities(int count, const TComponents& ...components) {
+	std::vector<Entity> entities = CreateEntities(count);
+	if (entities.empty()) {
+		return entities;
+	}
+
+	// Append a copy of each component to its pool in one go
+	([&](const auto& component) {
+		using TComponent = std::decay_t<decltype(component)>;
+		if constexpr (IsChunkedComponent<TComponent>()) {
+			for (auto entity : entities) {
+				chunks.Emplace<TComponent>(entity.GetId(), component);
+			}
+		}
+		else if constexpr (!IsTagComponent<TComponent>()) {
+			AssurePool<TComponent>()->SetMany(entities, component);
+		}
+	}(components), ...);
+
+	Signature componentSignature;
+	(componentSignature.set(Component<TComponents>::GetId()), ...);
+	for (auto entity : entities) {
+		entityComponentSignatures[entity.GetId()] |= componentSignature;
+	}
+
+	return entities;
+}
+
+template <typename ...TOverrides>
+Entity Registry::Instantiate(const Prefab& prefab, TOverrides&& ...overrides) {
+	const int entityId = AllocateEntityId();
+	if (entityId == -1) {
+		return Entity(-1, -1);
+	}
+	Entity entity(entityId, entityGenerations[entityId]);
+	entitiesToBeAdded.push_back(entity);
+
+	Signature overriddenSignature;
+	(overriddenSignature.set(Component<std::decay_t<TOverrides>>::GetId()), ...);
 
-	TComponent newComponent(std::forward<TArgs>(args)...);
+	// Copy the prefab rows, except for the ones that are overridden
+	for (const auto& component : prefab.GetComponents()) {
+		if (!overriddenSignature.test(component->GetComponentId())) {
+			component->CopyTo(*this, entityId);
+		}
+	}
+	(EmplaceComponent<std::decay_t<TOverrides>>(entityId, std::forward<TOverrides>(overrides)), ...);
 
-	componentPool->Set(entityId, newComponent);
+	entityComponentSignatures[entityId] = prefab.GetComponentSignature() | overriddenSignature;
 
-	entityComponentSignatures[entityId].set(componentId);
+	if (prefab.GetGroupId() != -1) {
+		GroupEntity(entity, prefab.GetGroupId());
+	}
 
-	Logger::Log("Component id = " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId));
+	return entity;
+}
+
+template <typename TComponent>
+void PrefabComponent<TComponent>::CopyTo(Registry& registry, int entityId) const {
+	registry.EmplaceComponent<TComponent>(entityId, component);
+}
+
+template <typename ...TOverrides>
+void InstantiateCommand<TOverrides...>::Execute(Registry& registry, std::vector<Entity>& createdEntities) {
+	createdEntities[pendingIndex] = std::apply([&registry, this](TOverrides& ...components) {
+		return registry.Instantiate(*prefab, std::move(components)...);
+	}, overrides);
+}
+
+template <typename TComponent>
+void AddComponentCommand<TComponent>::Execute(Registry& registry, std::vector<Entity>& createdEntities) {
+	const Entity entity = target.Resolve(createdEntities);
+	if (registry.IsAlive(entity)) {
+		registry.AddComponent<TComponent>(entity, std::move(component));
+	}
+}
+
+template <typename TComponent>
+void RemoveComponentCommand<TComponent>::Execute(Registry& registry, std::vector<Entity>& createdEntities) {
+	const Entity entity = target.Resolve(createdEntities);
+	if (registry.IsAlive(entity)) {
+		registry.RemoveComponent<TComponent>(entity);
+	}
+}
+
+template <typename TComponent, typename ...TArgs>
+void Prefab::AddComponent(TArgs&& ...args) {
+	const auto componentId = Component<TComponent>::GetId();
+
+	// Replace the component if the prefab already has one of this type
+	if (componentSignature.test(componentId)) {
+		for (auto& component : components) {
+			if (component->GetComponentId() == componentId) {
+				component = std::make_unique<PrefabComponent<TComponent>>(std::forward<TArgs>(args)...);
+				return;
+			}
+		}
+	}
+
+	components.push_back(std::make_unique<PrefabComponent<TComponent>>(std::forward<TArgs>(args)...));
+	componentSignature.set(componentId);
+}
+
+template <typename TComponent, typename ...TArgs>
+void Registry::AddComponent(Entity entity, TArgs&& ...args) {
+	const auto componentId = Component<TComponent>::GetId();
+	const auto entityId = entity.GetId();
+
+	EmplaceComponent<TComponent>(entityId, std::forward<TArgs>(args)...);
+
+	if (!entityComponentSignatures[entityId].test(componentId)) {
+		entityComponentSignatures[entityId].set(componentId);
+		OnSignatureChanged(entity);
+	}
 
-	std::cout << "Componet id = " << componentId << "--> POOL size: " << componentPool->GetSize() << std::endl;
+#if ECS_LOG_COMPONENT_CHANGES
+	Logger::Log("Component id = " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId));
+#endif
 }
 
 
@@ -351,12 +2554,29 @@ void Registry::RemoveComponent(Entity entity) {
 	const auto componentId = Component<TComponent>::GetId();
 	const auto entityId = entity.GetId();
 
-	std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-	componentPool->Remove(entityId);
-
+	if (!entityComponentSignatures[entityId].test(componentId)) {
+		return;
+	}
 	entityComponentSignatures[entityId].set(componentId, false);
 
+	// Entities that are already in their systems keep the component data until the next Update(),
+	// so systems still iterating them this frame don't read a removed component
+	if (entityArchetypeIds[entityId] == -1) {
+		if constexpr (IsChunkedComponent<TComponent>()) {
+			chunks.Remove(entityId, componentId);
+		}
+		else if constexpr (!IsTagComponent<TComponent>()) {
+			GetPool<TComponent>()->Remove(entityId);
+		}
+	}
+	else if constexpr (IsChunkedComponent<TComponent>()) {
+		chunks.AddPendingRemoval();
+	}
+	OnSignatureChanged(entity);
+
+#if ECS_LOG_COMPONENT_CHANGES
 	Logger::Log("Component id = " + std::to_string(componentId) + " was removed to entity id " + std::to_string(entityId));
+#endif
 }
 
 
@@ -367,13 +2587,244 @@ bool Registry::HasComponent(Entity entity) const {
 	return entityComponentSignatures[entityId].test(componentId);
 }
 
-template <typename TComponent> 
-TComponent& Registry::GetComponent(Entity entity) const {
+template <typename TComponent>
+Pool<TComponent>* Registry::GetPool() const {
 	const auto componentId = Component<TComponent>::GetId();
-	const auto entityId = entity.GetId();
+	if (static_cast<size_t>(componentId) >= componentPools.size()) {
+		return nullptr;
+	}
+	return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename TComponent>
+Span<TComponent> Registry::GetComponents() const {
+	static_assert(!IsChunkedComponent<TComponent>(), "Chunked components are iterated with ViewChunks()");
+	auto componentPool = GetPool<TComponent>();
+	return componentPool ? componentPool->GetComponents() : Span<TComponent>();
+}
+
+template <typename TComponent, size_t Column>
+auto Registry::GetColumn() const {
+	using TColumn = decltype(std::declval<Pool<TComponent>&>().template GetColumn<Column>());
+	auto componentPool = GetPool<TComponent>();
+	return componentPool ? componentPool->template GetColumn<Column>() : TColumn();
+}
+
+template <typename TComponent>
+Span<const int> Registry::GetComponentEntityIds() const {
+	static_assert(!IsChunkedComponent<TComponent>(), "Chunked components are iterated with ViewChunks()");
+	auto componentPool = GetPool<TComponent>();
+	return componentPool ? componentPool->GetComponentEntityIds() : Span<const int>();
+}
+
+template <typename TComponent>
+void Registry::ReserveComponents(int count) {
+	if constexpr (!IsTagComponent<TComponent>() && !IsChunkedComponent<TComponent>()) {
+		AssurePool<TComponent>()->SetCapacityHint(count);
+	}
+}
+
+template <typename TComponent>
+void Registry::SetComponentMemoryResource(std::pmr::memory_resource* resource) {
+	static_assert(!IsTagComponent<TComponent>(), "Tag components have no pool to allocate");
+	static_assert(!IsChunkedComponent<TComponent>(), "Chunked components allocate from the memory resource of the registry");
+	const auto componentId = Component<TComponent>::GetId();
+	if (GetPool<TComponent>()) {
+		Logger::Err("The memory resource of a component must be set before its pool is created");
+		return;
+	}
+	if (componentId >= static_cast<int>(componentMemoryResources.size())) {
+		componentMemoryResources.resize(componentId + 1, nullptr);
+	}
+	componentMemoryResources[componentId] = resource;
+}
+
+template <typename TComponent>
+PoolStats Registry::GetPoolStats() const {
+	if constexpr (IsTagComponent<TComponent>() || IsChunkedComponent<TComponent>()) {
+		return PoolStats();
+	}
+	else {
+		auto componentPool = GetPool<TComponent>();
+		return componentPool ? componentPool->GetStats() : PoolStats();
+	}
+}
+
+template <typename TResource>
+TResource& Registry::Resource() {
+	const auto resourceId = ResourceType<TResource>::GetId();
+	if (resourceId >= static_cast<int>(resources.size())) {
+		resources.resize(resourceId + 1);
+	}
+	if (!resources[resourceId]) {
+		resources[resourceId] = std::make_shared<TResource>();
+	}
+	return *static_cast<TResource*>(resources[resourceId].get());
+}
+
+template <typename TResource, typename ...TArgs>
+TResource& Registry::SetResource(TArgs&& ...args) {
+	const auto resourceId = ResourceType<TResource>::GetId();
+	if (resourceId >= static_cast<int>(resources.size())) {
+		resources.resize(resourceId + 1);
+	}
+	resources[resourceId] = std::make_shared<TResource>(std::forward<TArgs>(args)...);
+	return *static_cast<TResource*>(resources[resourceId].get());
+}
+
+template <typename TResource>
+bool Registry::HasResource() const {
+	const auto resourceId = ResourceType<TResource>::GetId();
+	return resourceId < static_cast<int>(resources.size()) && resources[resourceId];
+}
+
+template <typename TResource>
+void Registry::RemoveResource() {
+	const auto resourceId = ResourceType<TResource>::GetId();
+	if (resourceId < static_cast<int>(resources.size())) {
+		resources[resourceId].reset();
+	}
+}
+
+template <typename TComponent, typename TCompare>
+void Registry::SortComponents(TCompare compare) {
+	static_assert(!IsTagComponent<TComponent>(), "Tag components have no pool to sort");
+	static_assert(!IsChunkedComponent<TComponent>(), "Chunked components are kept in archetype order");
+	auto componentPool = GetPool<TComponent>();
+	if (!componentPool) {
+		return;
+	}
+	if (IsPoolOwned(Component<TComponent>::GetId())) {
+		Logger::Err("A component pool owned by a group cannot be sorted");
+		return;
+	}
+	componentPool->SortBy(compare);
+}
+
+template <typename TComponent, typename TCompare>
+void Registry::SortComponentsIncremental(TCompare compare) {
+	static_assert(!IsTagComponent<TComponent>(), "Tag components have no pool to sort");
+	static_assert(!IsChunkedComponent<TComponent>(), "Chunked components are kept in archetype order");
+	auto componentPool = GetPool<TComponent>();
+	if (!componentPool) {
+		return;
+	}
+	if (IsPoolOwned(Component<TComponent>::GetId())) {
+		Logger::Err("A component pool owned by a group cannot be sorted");
+		return;
+	}
+	componentPool->SortByIncremental(compare);
+}
+
+template <typename ...TComponents, typename ...TExcluded, typename ...TFilters>
+ComponentView<TComponents...> Registry::View(Without<TExcluded...>, TFilters ...filters) const {
+	static_assert(sizeof...(TFilters) <= MAX_VIEW_TICK_FILTERS, "Too many view filters");
+	static_assert(!(IsTagComponent<typename TFilters::Type>() || ...), "Tag components have no ticks to filter on");
+	static_assert(!(IsChunkedComponent<typename ViewComponent<TComponents>::Type>() || ...), "Chunked components are iterated with ViewChunks()");
+
+	Signature requiredSignature;
+	((ViewComponent<TComponents>::isOptional ? void() : void(requiredSignature.set(Component<typename ViewComponent<TComponents>::Type>::GetId()))), ...);
+	(requiredSignature.set(Component<typename TFilters::Type>::GetId()), ...);
+
+	Signature excludedSignature;
+	(excludedSignature.set(Component<TExcluded>::GetId()), ...);
+
+	ComponentView<TComponents...> view(GetPool<typename ViewComponent<TComponents>::Type>()..., 
+		entityComponentSignatures, entityGenerations, requiredSignature, excludedSignature);
+	(view.AddTickFilter(GetPool<typename TFilters::Type>(), TFilters::isAdded, filters.sinceTick), ...);
+	return view;
+}
+
+template <typename TComponent>
+void Registry::KillAllWith() {
+	if constexpr (IsTagComponent<TComponent>() || IsChunkedComponent<TComponent>()) {
+		// Tag and chunked components have no pool, look for their bit in the signatures
+		const auto componentId = Component<TComponent>::GetId();
+		for (int entityId = 0; entityId < static_cast<int>(entityComponentSignatures.size()); entityId++) {
+			if (entityComponentSignatures[entityId].test(componentId)) {
+				KillEntity(Entity(entityId, entityGenerations[entityId]));
+			}
+		}
+	}
+	else if (auto componentPool = GetPool<TComponent>()) {
+		// A pool keeps the data of a removed component until the next Update(), skip the entities that lost it
+		const auto componentId = Component<TComponent>::GetId();
+		for (const int entityId : componentPool->GetEntityIds()) {
+			if (entityComponentSignatures[entityId].test(componentId)) {
+				KillEntity(Entity(entityId, entityGenerations[entityId]));
+			}
+		}
+	}
+}
+
+template <typename TComponent>
+typename ComponentAccess<TComponent>::MutReference Registry::GetComponentMut(Entity entity) {
+	if constexpr (IsTagComponent<TComponent>()) {
+		return GetTagInstance<TComponent>();
+	}
+	else if constexpr (IsChunkedComponent<TComponent>()) {
+		return chunks.Get<TComponent>(entity.GetId());
+	}
+	else {
+		return GetPool<TComponent>()->GetMut(entity.GetId());
+	}
+}
+
+template <typename TComponent> 
+typename ComponentAccess<TComponent>::Reference Registry::GetComponent(Entity entity) const {
+	if constexpr (IsTagComponent<TComponent>()) {
+		return GetTagInstance<TComponent>();
+	}
+	else if constexpr (IsChunkedComponent<TComponent>()) {
+		return chunks.Get<TComponent>(entity.GetId());
+	}
+	else {
+		return GetPool<TComponent>()->Get(entity.GetId());
+	}
+}
+
+template <typename ...TComponents>
+ChunkedView<TComponents...> Registry::ViewChunks() const {
+	static_assert((IsChunkedComponent<TComponents>() && ...), "Only the chunked components are stored in chunks");
+	return ChunkedView<TComponents...>(chunks, entityGenerations, entityComponentSignatures);
+}
+
+template <typename ...TComponents>
+OwningGroup<TComponents...> Registry::OwnGroup() {
+	static_assert(!(IsTagComponent<TComponents>() || ...), "Tag components have no pool to own");
+	static_assert(!(IsChunkedComponent<TComponents>() || ...), "Chunked components are already grouped by archetype");
+
+	Signature signature;
+	(signature.set(Component<TComponents>::GetId()), ...);
+
+	for (const auto& group : ownedGroups) {
+		if (group->signature == signature) {
+			return OwningGroup<TComponents...>(GetPool<TComponents>()..., group.get(), entityGenerations);
+		}
+		if (group->signature.Intersects(signature)) {
+			Logger::Err("A component pool can only be owned by one group");
+			return OwningGroup<TComponents...>(AssurePool<TComponents>()..., nullptr, entityGenerations);
+		}
+	}
+
+	auto group = std::make_unique<OwnedGroup>();
+	group->signature = signature;
+	group->pools = { AssurePool<TComponents>()... };
+	OwnedGroup* newGroup = group.get();
+	ownedGroups.push_back(std::move(group));
+
+	// Pack the entities that are already in their systems, the other ones join in the next Update()
+	// (the ids are copied, as packing the group reorders the pool)
+	using TFirstComponent = std::tuple_element_t<0, std::tuple<TComponents...>>;
+	const auto& poolEntityIds = GetPool<TFirstComponent>()->GetEntityIds();
+	const std::vector<int> entityIds(poolEntityIds.begin(), poolEntityIds.end());
+	for (const int entityId : entityIds) {
+		if (entityArchetypeIds[entityId] != -1) {
+			UpdateEntityOwnedGroups(entityId);
+		}
+	}
 
-	auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-	return componentPool->Get(entityId);
+	return OwningGroup<TComponents...>(GetPool<TComponents>()..., newGroup, entityGenerations);
 }
 ////////////////////////////////////////////////////////////
 
@@ -381,23 +2832,28 @@ TComponent& Registry::GetComponent(Entity entity) const {
 
 template <typename TComponent, typename ...TArgs>
 void Entity::AddComponent(TArgs&& ...args) {
-	registry->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
+	Registry::GetCurrent()->AddComponent<TComponent>(*this, std::forward<TArgs>(args)...);
 }
 
 
 template <typename TComponent>
 void Entity::RemoveComponent() {
-	registry->RemoveComponent<TComponent>(*this);
+	Registry::GetCurrent()->RemoveComponent<TComponent>(*this);
 }
 
 template <typename TComponent>
 bool Entity::HasComponent() const {
-	return registry->HasComponent<TComponent>(*this);
+	return Registry::GetCurrent()->HasComponent<TComponent>(*this);
+}
+
+template <typename TComponent>
+typename ComponentAccess<TComponent>::Reference Entity::GetComponent() const {
+	return Registry::GetCurrent()->GetComponent<TComponent>(*this);
 }
 
 template <typename TComponent>
-TComponent& Entity::GetComponent() const {
-	return registry->GetComponent<TComponent>(*this);
+typename ComponentAccess<TComponent>::MutReference Entity::GetComponentMut() const {
+	return Registry::GetCurrent()->GetComponentMut<TComponent>(*this);
 }
 
 
@@ -0,0 +1,116 @@
+#ifndef MEMORYRESOURCES_H
+#define MEMORYRESOURCES_H
+
+#include <memory_resource>
+#include <algorithm>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <cstdint>
+#endif
+
+/// <summary>
+/// Memory resources for the component pools (see Registry::SetMemoryResource)
+/// Any std::pmr resource works with the pools, for example a std::pmr::monotonic_buffer_resource as an arena
+/// for a world that is thrown away as a whole. The resources below cover alignment and page size
+/// </summary>
+
+// Size of a cache line, and of the widest SIMD registers (AVX-512)
+const size_t CACHE_LINE_SIZE = 64;
+
+// Aligns every allocation to a cache line: the packed component data then starts on a cache line,
+// and can be loaded with aligned SIMD instructions
+class AlignedMemoryResource : public std::pmr::memory_resource {
+	private:
+		std::pmr::memory_resource* upstream;
+
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			return upstream->allocate(bytes, std::max(alignment, CACHE_LINE_SIZE));
+		}
+
+		void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+			upstream->deallocate(memory, bytes, std::max(alignment, CACHE_LINE_SIZE));
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+
+	public:
+		explicit AlignedMemoryResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) : upstream(upstream) {}
+};
+
+#ifdef __linux__
+
+// Size of a huge page on x86-64 and most 64-bit ARM kernels
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Maps the large allocations (big pools of a large world) on huge pages: a single TLB entry covers 2 MB of
+// components instead of 4 KB. It uses the reserved huge pages (MAP_HUGETLB) when the system has some, and falls
+// back to normal pages aligned to 2 MB and advised as transparent huge pages.
+// Allocations smaller than half a huge page go to the upstream resource, they would waste most of the page
+class HugePageMemoryResource : public std::pmr::memory_resource {
+	private:
+		std::pmr::memory_resource* upstream;
+
+		static bool IsHuge(size_t bytes, size_t alignment) {
+			return bytes >= HUGE_PAGE_SIZE / 2 && alignment <= HUGE_PAGE_SIZE;
+		}
+
+		static size_t GetMappedSize(size_t bytes) {
+			return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+		}
+
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			if (!IsHuge(bytes, alignment)) {
+				return upstream->allocate(bytes, alignment);
+			}
+
+			const size_t size = GetMappedSize(bytes);
+			void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (memory != MAP_FAILED) {
+				return memory;
+			}
+
+			// No reserved huge pages: map one extra huge page, and unmap around a 2 MB aligned range
+			void* mapping = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mapping == MAP_FAILED) {
+				throw std::bad_alloc();
+			}
+			const uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+			const uintptr_t alignedStart = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+			if (alignedStart > start) {
+				munmap(mapping, alignedStart - start);
+			}
+			const uintptr_t end = start + size + HUGE_PAGE_SIZE;
+			if (end > alignedStart + size) {
+				munmap(reinterpret_cast<void*>(alignedStart + size), end - (alignedStart + size));
+			}
+
+			memory = reinterpret_cast<void*>(alignedStart);
+#ifdef MADV_HUGEPAGE
+			madvise(memory, size, MADV_HUGEPAGE);
+#endif
+			return memory;
+		}
+
+		void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+			if (!IsHuge(bytes, alignment)) {
+				upstream->deallocate(memory, bytes, alignment);
+				return;
+			}
+			munmap(memory, GetMappedSize(bytes));
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+
+	public:
+		explicit HugePageMemoryResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) : upstream(upstream) {}
+};
+
+#endif // __linux__
+
+#endif // !MEMORYRESOURCES_H
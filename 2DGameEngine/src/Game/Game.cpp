@@ -14,6 +14,8 @@
 #include "../Components/HealthComponent.h"
 #include "../Components/TextLabelComponent.h"
 
+#include "../Resources/GameResources.h"
+
 #include "../Systems/MovementSystem.h"
 #include "../Systems/RenderSystem.h"
 #include "../Systems/AnimationSystem.h"
@@ -27,6 +29,7 @@
 #include "../Systems/RenderTextSystem.h"
 #include "../Systems/RenderHealthBarSystem.h"
 #include "../Systems/RenderGUISystem.h"
+#include "../Systems/HierarchySystem.h"
 
 
 #include <SDL.h>
@@ -38,17 +41,12 @@
 #include <imgui/imgui_impl_sdl.h>
 #include <fstream>
 
-int Game::windowWidth;
-int Game::windowHeight;
-int Game::mapWidth;
-int Game::mapHeight;
-
 Game::Game() {
 	isRunning = false;
 	isDebug = false;
 	registry = std::make_unique<Registry>();
+	registry->SetMemoryResource(&poolMemory);
 	assetStore = std::make_unique<AssetStore>();
-	eventBus = std::make_unique<EventBus>();
 	Logger::Log("Game constructor called!");
 }
 
@@ -98,10 +96,10 @@ void Game::Initialize() {
 	//SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
 
 	// Init Camarea view 
-	camera.x = 0;
-	camera.y = 0;
-	camera.w = windowWidth;
-	camera.h = windowHeight;
+	registry->Resource<Camera>().view = { 0, 0, windowWidth, windowHeight };
+
+	// The render systems draw with the game renderer and assets
+	registry->SetResource<RenderContext>(RenderContext{ renderer, assetStore.get() });
 
 	isRunning = true;
 }
@@ -141,7 +139,7 @@ void Game::ProcessInput() {
 				if (sdlEvent.key.keysym.sym == SDLK_d) {
 					isDebug = !isDebug;
 				}
-				eventBus->EmitEvent<KeyPressedEvent>(static_cast<SDL_KeyCode>(sdlEvent.key.keysym.sym));
+				registry->Resource<EventBus>().EmitEvent<KeyPressedEvent>(static_cast<SDL_KeyCode>(sdlEvent.key.keysym.sym));
 
 				break;
 		}
@@ -152,15 +150,16 @@ void Game::ProcessInput() {
 void Game::LoadLevel(int level) {
 	// Add the systems that need to be processed in game
 	registry->AddSystem<MovementSystem>();
+	registry->AddSystem<HierarchySystem>();
 	registry->AddSystem<RenderSystem>();
 	registry->AddSystem<AnimationSystem>();
 	registry->AddSystem<CollisionSystem>();
 	registry->AddSystem<RenderColliderSystem>();
-	registry->AddSystem<DamageSystem>();
+	registry->AddSystem<DamageSystem>(registry->CreateCommandBuffer());
 	registry->AddSystem<KeyboardControlSystem>();
 	registry->AddSystem<CameraMovementSystem>();
-	registry->AddSystem<ProjectileEmitSystem>();
-	registry->AddSystem<ProjectileLifeCycleSystem>();
+	registry->AddSystem<ProjectileEmitSystem>(registry->CreateCommandBuffer());
+	registry->AddSystem<ProjectileLifeCycleSystem>(registry->CreateCommandBuffer());
 	registry->AddSystem<RenderTextSystem>();
 	registry->AddSystem<RenderHealthBarSystem>();
 	registry->AddSystem<RenderGUISystem>();
@@ -178,6 +177,16 @@ void Game::LoadLevel(int level) {
 	assetStore->AddFont("pico8-font-5", "./assets/fonts/pico-8.ttf", 5);
 	assetStore->AddFont("pico8-font-10", "./assets/fonts/pico-8.ttf", 10);
 
+	// The assets need the renderer and stay on the main thread, the entities of the level are built in their own
+	// registry on a worker thread and merged into the game registry once ready (see MergeLoadedLevel)
+	loadingLevel = std::async(std::launch::async, &Game::BuildLevel, this, level);
+}
+
+std::unique_ptr<Registry> Game::BuildLevel(int level) const {
+	auto levelRegistry = std::make_unique<Registry>();
+	// The worker thread must not keep pointing to the level registry once it is handed over to the game
+	Registry::CurrentScope currentScope(*levelRegistry);
+
 	// Load the tilemap
 	int tileSize = 32;
 	double tileScale = 2.5;
@@ -186,6 +195,19 @@ void Game::LoadLevel(int level) {
 	std::fstream mapFile;
 	mapFile.open("./assets/tilemaps/jungle.map");
 
+	// Size the pools for the tiles and the few entities of the level, so they don't reallocate while the level loads
+	const int numTiles = mapNumRows * mapNumCols;
+	const int numLevelEntities = 16;
+	levelRegistry->ReserveEntities(numTiles + numLevelEntities);
+	levelRegistry->ReserveComponents<TransformComponent>(numTiles + numLevelEntities);
+	levelRegistry->ReserveComponents<SpriteComponent>(numTiles + numLevelEntities);
+
+	// Create all the tiles in one batch, then place each one and pick its source rectangle from the map file
+	std::vector<Entity> tiles = levelRegistry->CreateEntities(numTiles,
+		TransformComponent(glm::vec2(0, 0), glm::vec2(tileScale, tileScale), 0.0),
+		SpriteComponent("tilemap-image", tileSize, tileSize, 0));
+
+	const int tilesGroup = Registry::GetGroupId("tiles");
 	for (int y = 0; y < mapNumRows; y++) {
 		for (int x = 0; x < mapNumCols; x++) {
 			char ch;
@@ -195,23 +217,22 @@ void Game::LoadLevel(int level) {
 			int srcRectX = (ch - '0') * tileSize;
 			mapFile.ignore();
 
-			Logger::Log("SRC X = " + std::to_string(srcRectX) + " Y = " + std::to_string(srcRectY));
-
-			Entity tile = registry->CreateEntity();
-			tile.Group("tiles");
-			tile.AddComponent<TransformComponent>(glm::vec2(x * (tileSize * tileScale), y * (tileSize * tileScale)), 
-												  glm::vec2(tileScale, tileScale),	
-												  0.0);
-			tile.AddComponent<SpriteComponent>("tilemap-image", tileSize, tileSize, 0, false, srcRectX, srcRectY);
+			Entity tile = tiles[y * mapNumCols + x];
+			tile.Group(tilesGroup);
+			tile.GetComponentMut<TransformComponent>() = TransformComponent(glm::vec2(x * (tileSize * tileScale), y * (tileSize * tileScale)), glm::vec2(tileScale, tileScale), 0.0);
+			auto& sprite = tile.GetComponent<SpriteComponent>();
+			sprite.srcRect.x = srcRectX;
+			sprite.srcRect.y = srcRectY;
 		}
 	}
 	mapFile.close();
 
-	mapWidth = mapNumCols * tileSize * tileScale;
-	mapHeight = mapNumRows * tileSize * tileScale;
+	auto& map = levelRegistry->Resource<MapBounds>();
+	map.width = mapNumCols * tileSize * tileScale;
+	map.height = mapNumRows * tileSize * tileScale;
 
 
-	Entity chopper = registry->CreateEntity();
+	Entity chopper = levelRegistry->CreateEntity();
 	chopper.Tag("player");
 	chopper.AddComponent<TransformComponent>(glm::vec2(100.0, 100.0), glm::vec2(1.0, 1.0), 0.0);
 	chopper.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0));
@@ -223,14 +244,14 @@ void Game::LoadLevel(int level) {
 	chopper.AddComponent<CameraFollowComponent>();
 	chopper.AddComponent<HealthComponent>(100);
 
-	Entity radar = registry->CreateEntity();
+	Entity radar = levelRegistry->CreateEntity();
 	radar.AddComponent<TransformComponent>(glm::vec2(windowWidth- 74, 10.0), glm::vec2(1.0, 1.0), 0.0);
 	radar.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0));
 	radar.AddComponent<SpriteComponent>("radar-image", 64, 64, 2, true);
 	radar.AddComponent<AnimationComponent>(8, 10, true);
 
 	// Create an entity
-	Entity tank = registry->CreateEntity();
+	Entity tank = levelRegistry->CreateEntity();
 	tank.Group("enemies");
 	tank.AddComponent<TransformComponent>(glm::vec2(1050.0, 165.0), glm::vec2(1.0, 1.0), 0.0);
 	tank.AddComponent<RigidBodyComponent>(glm::vec2(20, 0));
@@ -239,7 +260,7 @@ void Game::LoadLevel(int level) {
 	//tank.AddComponent<ProjectileEmitterComponent>(glm::vec2(100.0, 0.0), 3000, 5000, 15, false);
 	tank.AddComponent<HealthComponent>(100);
 
-	Entity truck = registry->CreateEntity();
+	Entity truck = levelRegistry->CreateEntity();
 	truck.Group("enemies");
 	truck.AddComponent<TransformComponent>(glm::vec2(150.0, 630.0), glm::vec2(1.0, 1.0), 0.0);
 	truck.AddComponent<RigidBodyComponent>(glm::vec2(0, 0));
@@ -248,22 +269,31 @@ void Game::LoadLevel(int level) {
 	truck.AddComponent<ProjectileEmitterComponent>(glm::vec2(0, -100), 2000, 5000, 10, false);
 	truck.AddComponent<HealthComponent>(100);
 
-	Entity treeA = registry->CreateEntity();
-	treeA.Group("obstacles");
-	treeA.AddComponent<TransformComponent>(glm::vec2(1200, 165.0), glm::vec2(1.0, 1.0), 0.0);
-	treeA.AddComponent<SpriteComponent>("tree-image", 16, 32, 2);
-	treeA.AddComponent<BoxColliderComponent>(16, 32);
+	Prefab treePrefab;
+	treePrefab.Group("obstacles");
+	treePrefab.AddComponent<SpriteComponent>("tree-image", 16, 32, 2);
+	treePrefab.AddComponent<BoxColliderComponent>(16, 32);
 
-	Entity treeB = registry->CreateEntity();
-	treeB.Group("obstacles");
-	treeB.AddComponent<TransformComponent>(glm::vec2(960, 165), glm::vec2(1.0, 1.0), 0.0);
-	treeB.AddComponent<SpriteComponent>("tree-image", 16, 32, 2);
-	treeB.AddComponent<BoxColliderComponent>(16, 32);
+	levelRegistry->Instantiate(treePrefab, TransformComponent(glm::vec2(1200, 165.0), glm::vec2(1.0, 1.0), 0.0));
+	levelRegistry->Instantiate(treePrefab, TransformComponent(glm::vec2(960, 165), glm::vec2(1.0, 1.0), 0.0));
 
-	Entity label = registry->CreateEntity();
+	Entity label = levelRegistry->CreateEntity();
 	SDL_Color green = { 0,255,0 };
 	label.AddComponent<TextLabelComponent>(glm::vec2(windowWidth / 2 - 125 , 10), "GAME ENGINE 2D --- VER 1.0", "charriot-font", green, true);
 	//tank.Kill();
+
+	return levelRegistry;
+}
+
+void Game::MergeLoadedLevel() {
+	if (!loadingLevel.valid() || loadingLevel.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return;
+	}
+
+	// Move all the level entities at once, they join their systems in the registry update of this frame
+	std::unique_ptr<Registry> levelRegistry = loadingLevel.get();
+	registry->MergeFrom(*levelRegistry);
+	registry->Resource<MapBounds>() = levelRegistry->Resource<MapBounds>();
 }
 
 // ~ Start in Unity
@@ -280,13 +310,14 @@ void Game::Update() {
 	}
 
 	// The diffrence in ticks since the last time, converted to sec
-	double deltaTime = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
+	registry->Resource<FrameTime>().deltaTime = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
 
 	// Store the current frame time
 	millisecsPreviousFrame = SDL_GetTicks();
 
 	// Reset all event handlers for the current frame
-	eventBus->Reset();
+	auto& eventBus = registry->Resource<EventBus>();
+	eventBus.Reset();
 
 	// Perform the subcription of the events for all systems
 	registry->GetSystem<DamageSystem>().SubcribeToEvents(eventBus);
@@ -294,16 +325,23 @@ void Game::Update() {
 	registry->GetSystem<KeyboardControlSystem>().SubcribeToEvents(eventBus);
 	registry->GetSystem<ProjectileEmitSystem>().SubscribeToEvents(eventBus);
 
+	// Bring in the level once the worker thread has built it
+	MergeLoadedLevel();
+
 	// Update the registry to process the entities that are waiting to be created/deleted
 	registry->Update();
 
+	// Give back a little of the memory left unused after a burst of entities (like a storm of projectiles)
+	registry->Shrink(SHRINK_BYTES_PER_FRAME);
+
 	// Update the systems
-	registry->GetSystem<MovementSystem>().Update(deltaTime);
-	registry->GetSystem<AnimationSystem>().Update();
-	registry->GetSystem<CollisionSystem>().Update(eventBus);
-	registry->GetSystem<ProjectileEmitSystem>().Update(registry);
-	registry->GetSystem<CameraMovementSystem>().Update(camera);
-	registry->GetSystem<ProjectileLifeCycleSystem>().Update();
+	registry->GetSystem<MovementSystem>().Update(*registry);
+	registry->GetSystem<HierarchySystem>().Update(*registry);
+	registry->GetSystem<AnimationSystem>().Update(*registry);
+	registry->GetSystem<CollisionSystem>().Update(*registry);
+	registry->GetSystem<ProjectileEmitSystem>().Update(*registry);
+	registry->GetSystem<CameraMovementSystem>().Update(*registry);
+	registry->GetSystem<ProjectileLifeCycleSystem>().Update(*registry);
 }
 
 void Game::Render() {
@@ -311,14 +349,14 @@ void Game::Render() {
 	SDL_RenderClear(renderer);
 
 	// Invoke all systems render
-	registry->GetSystem<RenderSystem>().Update(renderer, assetStore, camera);
-	registry->GetSystem<RenderTextSystem>().Update(renderer, assetStore, camera);
-	registry->GetSystem<RenderHealthBarSystem>().Update(renderer, assetStore, camera);
+	registry->GetSystem<RenderSystem>().Update(*registry);
+	registry->GetSystem<RenderTextSystem>().Update(*registry);
+	registry->GetSystem<RenderHealthBarSystem>().Update(*registry);
 
 	if (isDebug) {
-		registry->GetSystem<RenderColliderSystem>().Update(renderer, camera);
+		registry->GetSystem<RenderColliderSystem>().Update(*registry);
 
-		registry->GetSystem<RenderGUISystem>().Update(registry, camera);
+		registry->GetSystem<RenderGUISystem>().Update(*registry);
 	}
 
 	SDL_RenderPresent(renderer);
@@ -327,6 +365,7 @@ void Game::Render() {
 void Game::Destroy() {
 	ImGuiSDL::Deinitialize();
 	ImGui::DestroyContext();
+	registry->GetSystem<RenderHealthBarSystem>().ClearHealthLabels();
 	SDL_DestroyRenderer(renderer);
 	SDL_DestroyWindow(window);
 	SDL_Quit();
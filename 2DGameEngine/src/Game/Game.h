@@ -2,14 +2,19 @@
 #define GAME_H
 
 #include "../ECS/ECS.h"
+#include "../ECS/MemoryResources.h"
 #include "../AssetStore/AssetStore.h"
 #include "../EventBus/EventBus.h"
 #include <SDL.h>
+#include <future>
 
 
 const int FPS = 60;
 const int MILISECS_PER_FRAME = 1000 / FPS;
 
+// Most memory the registry moves each frame to release unused pool capacity
+const size_t SHRINK_BYTES_PER_FRAME = 64 * 1024;
+
 class Game {
 	private:
 		bool isRunning;
@@ -17,11 +22,23 @@ class Game {
 		int millisecsPreviousFrame = 0;
 		SDL_Window* window;
 		SDL_Renderer* renderer;
-		SDL_Rect camera;
+		int windowWidth;
+		int windowHeight;
+
+		// Cache line aligned memory for the component pools, declared before the registry to outlive it
+		AlignedMemoryResource poolMemory;
 
 		std::unique_ptr<Registry> registry;
 		std::unique_ptr<AssetStore> assetStore;
-		std::unique_ptr<EventBus> eventBus;
+
+		// Registry of the level being built on a worker thread
+		std::future<std::unique_ptr<Registry>> loadingLevel;
+
+		// Build the entities of a level in a new registry, runs on a worker thread
+		std::unique_ptr<Registry> BuildLevel(int level) const;
+
+		// Merge the level into the game registry once it is built, at the start of a frame
+		void MergeLoadedLevel();
 
 	public:
 		Game();
@@ -34,11 +51,6 @@ class Game {
 		void Update();
 		void Render();
 		void Destroy();
-
-		static int windowWidth;
-		static int windowHeight;
-		static int mapWidth;
-		static int mapHeight;
 };
 
 #endif
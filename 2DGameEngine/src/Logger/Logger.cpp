@@ -2,19 +2,23 @@
 #include <iostream>
 #include <ctime>
 #include <chrono>
+#include <mutex>
 
 
 std::vector<LogEntry> Logger::messages;
 
+// Entities can be created on worker threads (see Registry::MergeFrom), the log is shared by all of them
+static std::mutex logMutex;
+
 std::string CurrentDateTimeToString() {
 	std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
 	std::string output(30, '\0');
-	std::tm timeinfo;
 	std::strftime(&output[0], output.size(), "%d-%b-%Y %H:%M:%S", std::localtime(&now));
 	return output;
 }
 
 void Logger::Log(const std::string& message) {
+	std::lock_guard<std::mutex> lock(logMutex);
 	LogEntry logEntry;
 	logEntry.type = LOG_INFO;
 	logEntry.message = "LOG: [" + CurrentDateTimeToString() + "]: " + message;
@@ -24,6 +28,7 @@ void Logger::Log(const std::string& message) {
 }
 
 void Logger::Err(const std::string& message) {
+	std::lock_guard<std::mutex> lock(logMutex);
 	LogEntry logEntry;
 	logEntry.type = LOG_ERROR;
 	logEntry.message = "ERR: [" + CurrentDateTimeToString() + "]: " + message;
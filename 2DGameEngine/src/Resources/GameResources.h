@@ -0,0 +1,32 @@
+#ifndef GAMERESOURCES_H
+#define GAMERESOURCES_H
+
+#include <SDL.h>
+
+class AssetStore;
+
+// Resources of the game registry, see Registry::Resource<T>()
+
+// Size of the loaded map in pixels
+struct MapBounds {
+	int width = 0;
+	int height = 0;
+};
+
+// Area of the map that is visible in the window
+struct Camera {
+	SDL_Rect view = { 0, 0, 0, 0 };
+};
+
+// Time between the previous frame and the current one, in seconds
+struct FrameTime {
+	double deltaTime = 0.0;
+};
+
+// What the render systems draw with, the renderer and the assets are owned by the game
+struct RenderContext {
+	SDL_Renderer* renderer = nullptr;
+	AssetStore* assetStore = nullptr;
+};
+
+#endif // !GAMERESOURCES_H
@@ -6,6 +6,7 @@
 
 #include "../Components/CameraFollowComponent.h"
 #include "../Components/TransformComponent.h"
+#include "../Resources/GameResources.h"
 
 class CameraMovementSystem : public System {
 	public:
@@ -14,19 +15,22 @@ class CameraMovementSystem : public System {
 			RequireComponent<TransformComponent>();
 		}
 
-		void Update(SDL_Rect& camera) {
+		void Update(Registry& registry) {
+			auto& camera = registry.Resource<Camera>().view;
+			const auto& map = registry.Resource<MapBounds>();
+
 			for (auto entity : GetSystemEntities()) {
 				const auto transform = entity.GetComponent<TransformComponent>();
 
 
 
 				// change camera property based on the entity transform position 
-				if (transform.position.x + (camera.w / 2) < Game::mapWidth) {
-					camera.x = transform.position.x - (Game::windowWidth / 2);
+				if (transform.position.x + (camera.w / 2) < map.width) {
+					camera.x = transform.position.x - (camera.w / 2);
 				}
 
-				if (transform.position.y + (camera.h / 2) < Game::mapHeight) {
-					camera.y = transform.position.y - (Game::windowHeight / 2);
+				if (transform.position.y + (camera.h / 2) < map.height) {
+					camera.y = transform.position.y - (camera.h / 2);
 				}
 
 				// Keep the camera rectangle view inside the screen limits
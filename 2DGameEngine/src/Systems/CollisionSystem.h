@@ -15,24 +15,22 @@ class CollisionSystem : public System {
 
 		}
 
-		void Update(std::unique_ptr<EventBus>& eventBus) {
-			auto entities = GetSystemEntities();
+		void Update(Registry& registry) {
+			auto& eventBus = registry.Resource<EventBus>();
+			const auto entities = registry.View<TransformComponent, BoxColliderComponent>();
 
-			for (auto i = entities.begin(); i != entities.end(); i++) {
+			for (auto i = entities.begin(); i != entities.end(); ++i) {
 				Entity a = *i;
 
-				auto aTransform = a.GetComponent<TransformComponent>();
-				auto aCollider = a.GetComponent<BoxColliderComponent>();
+				const auto& aTransform = entities.Get<TransformComponent>(a);
+				const auto& aCollider = entities.Get<BoxColliderComponent>(a);
 
-				for (auto j = i; j != entities.end(); j++) {
+				auto j = i;
+				for (++j; j != entities.end(); ++j) {
 					Entity b = *j;
 
-					if (a == b) {
-						continue;
-					}
-
-					auto bTransform = b.GetComponent<TransformComponent>();
-					auto bCollider = b.GetComponent<BoxColliderComponent>();
+					const auto& bTransform = entities.Get<TransformComponent>(b);
+					const auto& bCollider = entities.Get<BoxColliderComponent>(b);
 
 					bool collisionHappened = CheckAABBCollision(
 						aTransform.position.x + aCollider.offset.x,
@@ -47,7 +45,7 @@ class CollisionSystem : public System {
 					if (collisionHappened) {
 						Logger::Log("Entity " + std::to_string(a.GetId()) + " is colliding with entity " + std::to_string(b.GetId()));
 
-						eventBus->EmitEvent<CollisionEvent>(a, b);
+						eventBus.EmitEvent<CollisionEvent>(a, b);
 					}
 				}
 			}
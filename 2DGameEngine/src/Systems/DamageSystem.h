@@ -9,13 +9,21 @@
 #include "../Events/CollisionEvent.h"
 
 class DamageSystem : public System {
+	private:
+		const int projectilesGroup = Registry::GetGroupId("projectiles");
+		const int enemiesGroup = Registry::GetGroupId("enemies");
+		const int playerTag = Registry::GetTagId("player");
+
+		// The hit entities are killed when the registry plays back the buffer
+		CommandBuffer& commands;
+
 	public:
-		DamageSystem() {
+		DamageSystem(CommandBuffer& commands) : commands(commands) {
 			RequireComponent<BoxColliderComponent>();
 		}
 
-		void SubcribeToEvents(std::unique_ptr<EventBus>& eventBus) {
-			eventBus->SubcribeToEvent<CollisionEvent>(this, &DamageSystem::onCollision);
+		void SubcribeToEvents(EventBus& eventBus) {
+			eventBus.SubcribeToEvent<CollisionEvent>(this, &DamageSystem::onCollision);
 		}
 
 		void onCollision(CollisionEvent& event) {
@@ -23,16 +31,16 @@ class DamageSystem : public System {
 			Entity b = event.b;
 			Logger::Log("Damage system : " + std::to_string(a.GetId()) + " and " + std::to_string(b.GetId()));
 
-			if (a.BelongsToGroup("projectiles") && b.HasTag("player")) {
+			if (a.BelongsToGroup(projectilesGroup) && b.HasTag(playerTag)) {
 				OnProjectileHitsPlayer(a, b);
 			}
-			if (b.BelongsToGroup("projectiles") && a.HasTag("player")) {
+			if (b.BelongsToGroup(projectilesGroup) && a.HasTag(playerTag)) {
 				OnProjectileHitsPlayer(b, a);
 			}
-			if (a.BelongsToGroup("projectiles") && b.BelongsToGroup("enemies")) {
+			if (a.BelongsToGroup(projectilesGroup) && b.BelongsToGroup(enemiesGroup)) {
 				OnProjectileHitsEnemy(a, b);
 			}
-			if (b.BelongsToGroup("projectiles") && a.BelongsToGroup("enemies")) {
+			if (b.BelongsToGroup(projectilesGroup) && a.BelongsToGroup(enemiesGroup)) {
 				OnProjectileHitsEnemy(b, a);
 			}
 		}
@@ -41,17 +49,17 @@ class DamageSystem : public System {
 			auto projectileComponent = projectile.GetComponent<ProjectileComponent>();
 
 			if (!projectileComponent.isFriendly) {
-				auto& health = player.GetComponent<HealthComponent>();
+				auto& health = player.GetComponentMut<HealthComponent>();
 
 				// Subtract health player
 				health.heathPercentage -= projectileComponent.hitPercentDamage;
 
 				// Die
 				if (health.heathPercentage <= 0) {
-					player.Kill();
+					commands.KillEntity(player);
 				}
 
-				projectile.Kill();
+				commands.KillEntity(projectile);
 			}
 		}
 
@@ -59,21 +67,21 @@ class DamageSystem : public System {
 			const auto projectileComponent = projectile.GetComponent<ProjectileComponent>();
 
 			if (projectileComponent.isFriendly) {
-				auto& health = enemy.GetComponent<HealthComponent>();
+				auto& health = enemy.GetComponentMut<HealthComponent>();
 
 				// Subtract health player
 				health.heathPercentage -= projectileComponent.hitPercentDamage;
 
 				// Die
 				if (health.heathPercentage <= 0) {
-					enemy.Kill();
+					commands.KillEntity(enemy);
 				}
 
-				projectile.Kill();
+				commands.KillEntity(projectile);
 			}
 		}
 
-		void Update() {
+		void Update(Registry& registry) {
 
 		}
 };
@@ -0,0 +1,178 @@
+#ifndef HIERARCHYSYSTEM_H
+#define HIERARCHYSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/ParentComponent.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+
+/// <summary>
+/// Hierarchy System
+/// Computes the world TransformComponent of the attached entities from the transform of their parent.
+/// The nodes are kept sorted breadth-first (parents before children), with the world transform of each node
+/// stored next to it, so the propagation is a single linear pass that reads the parent from an earlier slot.
+/// Only the subtrees whose root moved, or whose local transform changed, are recomputed
+/// </summary>
+class HierarchySystem : public System {
+	private:
+		struct HierarchyNode {
+			Entity entity;
+			Entity parent;
+
+			// Index of the parent node, -1 when the parent is a root (an entity that is not attached itself)
+			int parentIndex;
+
+			// World transform of the node, and for the nodes attached to a root the last seen root transform
+			TransformComponent world;
+			TransformComponent rootWorld;
+
+			bool isDirty;
+		};
+
+		// Nodes in breadth-first order
+		std::vector<HierarchyNode> nodes;
+
+		// Index of the node of each entity [Vector index = entity id], -1 when the entity is not attached
+		std::vector<int> nodeIndexPerEntity;
+
+		// Change tick of the registry at the last update
+		uint32_t lastTick = 0;
+
+		// Membership version of the system when the nodes were last built
+		uint32_t nodesMembershipVersion = 0;
+
+		int GetNodeIndex(Entity entity) const {
+			const int entityId = entity.GetId();
+			if (entityId >= static_cast<int>(nodeIndexPerEntity.size())) {
+				return -1;
+			}
+			const int nodeIndex = nodeIndexPerEntity[entityId];
+			return nodeIndex != -1 && nodes[nodeIndex].entity == entity ? nodeIndex : -1;
+		}
+
+		static bool IsSameTransform(const TransformComponent& a, const TransformComponent& b) {
+			return a.position == b.position && a.scale == b.scale && a.rotation == b.rotation;
+		}
+
+		static TransformComponent CombineTransforms(const TransformComponent& parentWorld, const ParentComponent& local) {
+			const double angle = glm::radians(parentWorld.rotation);
+			const glm::vec2 offset = local.localPosition * parentWorld.scale;
+			const glm::vec2 rotatedOffset(
+				static_cast<float>(offset.x * std::cos(angle) - offset.y * std::sin(angle)),
+				static_cast<float>(offset.x * std::sin(angle) + offset.y * std::cos(angle))
+			);
+			return TransformComponent(parentWorld.position + rotatedOffset, parentWorld.scale * local.localScale, parentWorld.rotation + local.localRotation);
+		}
+
+		// Sort the attached entities breadth-first, by their depth in the hierarchy
+		void Rebuild(Registry& registry) {
+			const auto& entities = GetSystemEntities();
+			nodesMembershipVersion = GetMembershipVersion();
+
+			nodes.clear();
+			std::fill(nodeIndexPerEntity.begin(), nodeIndexPerEntity.end(), -1);
+			for (auto entity : entities) {
+				if (entity.GetId() >= static_cast<int>(nodeIndexPerEntity.size())) {
+					nodeIndexPerEntity.resize(entity.GetId() + 1, -1);
+				}
+				nodeIndexPerEntity[entity.GetId()] = static_cast<int>(nodes.size());
+				nodes.push_back({ entity, registry.GetComponent<ParentComponent>(entity).parent, -1, TransformComponent(), TransformComponent(), true });
+			}
+
+			// Depth of each node: number of attached ancestors, each depth is computed only once
+			std::vector<int> depths(nodes.size(), -1);
+			std::vector<int> path;
+			for (size_t i = 0; i < nodes.size(); i++) {
+				int nodeIndex = static_cast<int>(i);
+				while (nodeIndex != -1 && depths[nodeIndex] == -1 && path.size() <= nodes.size()) {
+					path.push_back(nodeIndex);
+					nodeIndex = GetNodeIndex(nodes[nodeIndex].parent);
+				}
+				if (path.size() > nodes.size()) {
+					Logger::Err("Entity id " + std::to_string(nodes[i].entity.GetId()) + " is its own ancestor");
+					nodeIndex = -1;
+				}
+				int depth = nodeIndex == -1 ? -1 : depths[nodeIndex];
+				for (auto pathNode = path.rbegin(); pathNode != path.rend(); ++pathNode) {
+					depths[*pathNode] = ++depth;
+				}
+				path.clear();
+			}
+
+			std::vector<std::pair<int, HierarchyNode>> nodesWithDepth;
+			nodesWithDepth.reserve(nodes.size());
+			for (size_t i = 0; i < nodes.size(); i++) {
+				nodesWithDepth.emplace_back(depths[i], nodes[i]);
+			}
+			std::stable_sort(nodesWithDepth.begin(), nodesWithDepth.end(), [](const auto& a, const auto& b) {
+				return a.first < b.first;
+			});
+
+			for (size_t i = 0; i < nodesWithDepth.size(); i++) {
+				nodes[i] = nodesWithDepth[i].second;
+				nodeIndexPerEntity[nodes[i].entity.GetId()] = static_cast<int>(i);
+			}
+			for (auto& node : nodes) {
+				node.parentIndex = GetNodeIndex(node.parent);
+			}
+		}
+
+	public:
+		HierarchySystem() {
+			RequireComponent<TransformComponent>();
+			RequireComponent<ParentComponent>();
+		}
+
+		void Update(Registry& registry) {
+			// Entities attached or detached since the last update change the order of the nodes
+			bool needsRebuild = nodesMembershipVersion != GetMembershipVersion();
+			registry.View<ParentComponent>(Without<>(), Changed<ParentComponent>(lastTick)).Each([&](Entity entity, const ParentComponent& parent) {
+				const int nodeIndex = GetNodeIndex(entity);
+				if (nodeIndex == -1 || nodes[nodeIndex].parent != parent.parent) {
+					needsRebuild = true;
+				}
+				else {
+					nodes[nodeIndex].isDirty = true;
+				}
+			});
+			if (needsRebuild) {
+				Rebuild(registry);
+			}
+
+			// Parents come first, so the world transform of a parent node is always up to date when its children read it
+			for (auto& node : nodes) {
+				const TransformComponent* parentWorld = nullptr;
+				if (node.parentIndex != -1) {
+					const auto& parentNode = nodes[node.parentIndex];
+					node.isDirty = node.isDirty || parentNode.isDirty;
+					parentWorld = &parentNode.world;
+				}
+				else {
+					if (!registry.IsAlive(node.parent) || !registry.HasComponent<TransformComponent>(node.parent)) {
+						continue;
+					}
+					const auto& rootTransform = registry.GetComponent<TransformComponent>(node.parent);
+					if (!IsSameTransform(rootTransform, node.rootWorld)) {
+						node.rootWorld = rootTransform;
+						node.isDirty = true;
+					}
+					parentWorld = &node.rootWorld;
+				}
+
+				if (node.isDirty) {
+					node.world = CombineTransforms(*parentWorld, registry.GetComponent<ParentComponent>(node.entity));
+					registry.GetComponentMut<TransformComponent>(node.entity) = node.world;
+				}
+			}
+
+			for (auto& node : nodes) {
+				node.isDirty = false;
+			}
+			lastTick = registry.GetTick();
+		}
+};
+
+#endif // !HIERARCHYSYSTEM_H
@@ -17,8 +17,8 @@ class KeyboardControlSystem : public System {
 			RequireComponent<SpriteComponent>();
 		} 
 
-		void SubcribeToEvents(std::unique_ptr<EventBus>& eventBus) {
-			eventBus->SubcribeToEvent<KeyPressedEvent>(this, &KeyboardControlSystem::OnKeyPressed);
+		void SubcribeToEvents(EventBus& eventBus) {
+			eventBus.SubcribeToEvent<KeyPressedEvent>(this, &KeyboardControlSystem::OnKeyPressed);
 		}
 
 		void OnKeyPressed(KeyPressedEvent& event) {
@@ -30,24 +30,23 @@ class KeyboardControlSystem : public System {
 			for (auto entity : GetSystemEntities()) {
 				const auto keyboardControl = entity.GetComponent<KeyboardControlComponent>();
 				auto& sprite = entity.GetComponent<SpriteComponent>();
-				auto& rigidbody = entity.GetComponent<RigidBodyComponent>();
 
 				switch (event.symbol)
 				{
 					case SDLK_UP:
-						rigidbody.velocity = keyboardControl.upVelocity;
+						entity.GetComponentMut<RigidBodyComponent>() = RigidBodyComponent(keyboardControl.upVelocity);
 						sprite.srcRect.y = sprite.height * 0;
 						break;
 					case SDLK_RIGHT:
-						rigidbody.velocity = keyboardControl.rightVelocity;
+						entity.GetComponentMut<RigidBodyComponent>() = RigidBodyComponent(keyboardControl.rightVelocity);
 						sprite.srcRect.y = sprite.height * 1;
 						break;
 					case SDLK_DOWN:
-						rigidbody.velocity = keyboardControl.downVelocity;
+						entity.GetComponentMut<RigidBodyComponent>() = RigidBodyComponent(keyboardControl.downVelocity);
 						sprite.srcRect.y = sprite.height * 2;
 						break;
 					case SDLK_LEFT:
-						rigidbody.velocity = keyboardControl.leftVelocity;
+						entity.GetComponentMut<RigidBodyComponent>() = RigidBodyComponent(keyboardControl.leftVelocity);
 						sprite.srcRect.y = sprite.height * 3;
 						break;
 					default:
@@ -6,18 +6,24 @@
 #include "../Events/CollisionEvent.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
+#include "../Resources/GameResources.h"
 
 #include <algorithm> 
 
 class MovementSystem : public System {
+	private:
+		const int enemiesGroup = Registry::GetGroupId("enemies");
+		const int obstaclesGroup = Registry::GetGroupId("obstacles");
+		const int playerTag = Registry::GetTagId("player");
+
 	public:
 		MovementSystem() {
 			RequireComponent<TransformComponent>();
 			RequireComponent<RigidBodyComponent>();
 		}
 
-		void SubscribeToEvents(const std::unique_ptr<EventBus>& eventBus) {
-			eventBus->SubcribeToEvent<CollisionEvent>(this, &MovementSystem::OnCollision);
+		void SubscribeToEvents(EventBus& eventBus) {
+			eventBus.SubcribeToEvent<CollisionEvent>(this, &MovementSystem::OnCollision);
 		}
 
 		void OnCollision(CollisionEvent& event) {
@@ -25,17 +31,18 @@ class MovementSystem : public System {
 			Entity b = event.b;
 			Logger::Log("Damage system : " + std::to_string(a.GetId()) + " and " + std::to_string(b.GetId()));
 
-			if (a.BelongsToGroup("enemies") && b.BelongsToGroup("obstacles")) {
+			if (a.BelongsToGroup(enemiesGroup) && b.BelongsToGroup(obstaclesGroup)) {
 				OnEnemyHitsObstacle(a, b);
 			}
-			if (a.BelongsToGroup("obstacles") && b.BelongsToGroup("enemies")) {
+			if (a.BelongsToGroup(obstaclesGroup) && b.BelongsToGroup(enemiesGroup)) {
 				OnEnemyHitsObstacle(b, a);
 			}
 		}
 
 		void OnEnemyHitsObstacle(Entity enemy, Entity obstacle) {
 			if (enemy.HasComponent<RigidBodyComponent>() && enemy.HasComponent<SpriteComponent>()) {
-				auto& enemyRigidbody = enemy.GetComponent<RigidBodyComponent>();
+				// Rigid bodies are stored one field per array: modify a copy and store it back
+				RigidBodyComponent enemyRigidbody = enemy.GetComponent<RigidBodyComponent>();
 				auto& enemySprite = enemy.GetComponent<SpriteComponent>();
 
 				if (enemyRigidbody.velocity.x != 0) {
@@ -46,39 +53,60 @@ class MovementSystem : public System {
 					enemyRigidbody.velocity.y *= -1;
 					enemySprite.flip = (enemySprite.flip == SDL_FLIP_NONE ? SDL_FLIP_VERTICAL : SDL_FLIP_NONE);
 				}
-
+				enemy.GetComponentMut<RigidBodyComponent>() = enemyRigidbody;
 			}
 
 		}
 
-		void Update(double deltaTime) {
-			// Loop all entities that the system is interested in 
-			for (auto entity : GetSystemEntities()) {
-
-				// Update entity position based on its velocity every frame of the game loop 
-				auto& transform = entity.GetComponent<TransformComponent>();
-				const auto rigidbody = entity.GetComponent<RigidBodyComponent>();
-
-				transform.position.x += rigidbody.velocity.x * deltaTime;
-				transform.position.y += rigidbody.velocity.y * deltaTime;
+		void Update(Registry& registry) {
+			const double deltaTime = registry.Resource<FrameTime>().deltaTime;
+			const auto& map = registry.Resource<MapBounds>();
+
+			// All the entities that have a transform and a rigid body, the first slots of both pools (owning group)
+			const auto group = registry.OwnGroup<TransformComponent, RigidBodyComponent>();
+			const int size = group.GetSize();
+			float* positionX = group.GetColumn<TransformComponent, TransformComponent::PositionX>().data();
+			float* positionY = group.GetColumn<TransformComponent, TransformComponent::PositionY>().data();
+			const float* velocityX = group.GetColumn<RigidBodyComponent, RigidBodyComponent::VelocityX>().data();
+			const float* velocityY = group.GetColumn<RigidBodyComponent, RigidBodyComponent::VelocityY>().data();
+			const float step = static_cast<float>(deltaTime);
+
+			// Update entity position based on its velocity every frame of the game loop,
+			// a plain loop over the field arrays that the compiler vectorizes
+			for (int i = 0; i < size; i++) {
+				positionX[i] += velocityX[i] * step;
+				positionY[i] += velocityY[i] * step;
+			}
 
-				bool isEntityOutsideMap = (
-					transform.position.x < 0 || transform.position.x > Game::mapWidth ||
-					transform.position.y < 0 || transform.position.y > Game::mapHeight
+			// Only the entities close to the map borders can be outside of it, or need to be held in by the clamp
+			const auto entityIds = group.GetEntityIds();
+			for (int i = 0; i < size; i++) {
+				const bool isEntityNearBorder = (
+					positionX[i] < 10.0f || positionX[i] > map.width - 50.0f ||
+					positionY[i] < 10.0f || positionY[i] > map.height - 50.0f
 					);
+				if (!isEntityNearBorder) {
+					continue;
+				}
+
+				Entity entity = registry.GetEntity(entityIds[i]);
 
 				// Prevent the main player from going outside the map
-				if (entity.HasTag("player")) {
-					transform.position.x = std::clamp(transform.position.x, 10.0f, Game::mapWidth - 50.0f);
-					transform.position.y = std::clamp(transform.position.y, 10.0f, Game::mapHeight - 50.0f);
+				if (entity.HasTag(playerTag)) {
+					positionX[i] = std::clamp(positionX[i], 10.0f, map.width - 50.0f);
+					positionY[i] = std::clamp(positionY[i], 10.0f, map.height - 50.0f);
+					continue;
 				}
 
 				// Kill entity if it is outside the map
-				if (isEntityOutsideMap && !entity.HasTag("player")) {
+				const bool isEntityOutsideMap = (
+					positionX[i] < 0 || positionX[i] > map.width ||
+					positionY[i] < 0 || positionY[i] > map.height
+					);
+				if (isEntityOutsideMap) {
 					entity.Kill();
 				}
 			}
-
 		}
 };
 
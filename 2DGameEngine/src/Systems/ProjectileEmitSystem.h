@@ -17,14 +17,28 @@
 #include "../Components/CameraFollowComponent.h"
 
 class ProjectileEmitSystem : public System {
+	private:
+		// Blueprint of every projectile, each emission only overrides the components that change
+		Prefab projectilePrefab;
+
+		// The projectiles are created when the registry plays back the buffer
+		CommandBuffer& commands;
+
 	public:
-		ProjectileEmitSystem() {
+		ProjectileEmitSystem(CommandBuffer& commands) : commands(commands) {
 			RequireComponent<ProjectileEmitterComponent>();
 			RequireComponent<TransformComponent>();
+
+			projectilePrefab.Group("projectiles");
+			projectilePrefab.AddComponent<TransformComponent>(glm::vec2(0.0, 0.0), glm::vec2(1.0, 1.0), 0.0);
+			projectilePrefab.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
+			projectilePrefab.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
+			projectilePrefab.AddComponent<BoxColliderComponent>(4, 4, glm::vec2(0, 0));
+			projectilePrefab.AddComponent<ProjectileComponent>();
 		}
 
-		void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
-			eventBus->SubcribeToEvent<KeyPressedEvent>(this, &ProjectileEmitSystem::OnKeyPressed);
+		void SubscribeToEvents(EventBus& eventBus) {
+			eventBus.SubcribeToEvent<KeyPressedEvent>(this, &ProjectileEmitSystem::OnKeyPressed);
 		}
 
 		void OnKeyPressed(KeyPressedEvent& event) {
@@ -56,19 +70,16 @@ class ProjectileEmitSystem : public System {
 						projectileVelocity.y = projectileEmitter.projectileVelocity.y * directionY;
 
 						// Create new projectile entity and add it to the world 
-						Entity projectile = entity.registry->CreateEntity();
-						projectile.Group("projectiles");
-						projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0.0);
-						projectile.AddComponent<RigidBodyComponent>(projectileVelocity);
-						projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-						projectile.AddComponent<BoxColliderComponent>(4, 4, glm::vec2(0, 0));
-						projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration);
+						commands.Instantiate(projectilePrefab,
+							TransformComponent(projectilePosition, glm::vec2(1.0, 1.0), 0.0),
+							RigidBodyComponent(projectileVelocity),
+							ProjectileComponent(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration));
 					}
 				}
 			}
 		}
 
-		void Update(std::unique_ptr<Registry>& registry) {
+		void Update(Registry& registry) {
 			for (auto entity : GetSystemEntities()) {
 				auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
 				const auto transform = entity.GetComponent<TransformComponent>();
@@ -88,13 +99,10 @@ class ProjectileEmitSystem : public System {
 					}
 
 					// Add new projectile to the registry
-					Entity projectile = registry->CreateEntity();
-					projectile.Group("projectiles");
-					projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0.0);
-					projectile.AddComponent<RigidBodyComponent>(projectileEmitter.projectileVelocity);
-					projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-					projectile.AddComponent<BoxColliderComponent>(4, 4, glm::vec2(0, 0));
-					projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration);
+					commands.Instantiate(projectilePrefab,
+						TransformComponent(projectilePosition, glm::vec2(1.0, 1.0), 0.0),
+						RigidBodyComponent(projectileEmitter.projectileVelocity),
+						ProjectileComponent(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration));
 
 					// update the projectile emitter component last emission
 					projectileEmitter.lastEmissionTime = SDL_GetTicks();
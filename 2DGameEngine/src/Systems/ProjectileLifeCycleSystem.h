@@ -4,18 +4,21 @@
 #include "../Components/ProjectileComponent.h"
 
 class ProjectileLifeCycleSystem : public System {
+	private:
+		CommandBuffer& commands;
+
 	public:
-		ProjectileLifeCycleSystem() {
+		ProjectileLifeCycleSystem(CommandBuffer& commands) : commands(commands) {
 			RequireComponent<ProjectileComponent>();
 		}
 
-		void Update() {
+		void Update(Registry& registry) {
 			for (auto entity : GetSystemEntities()) {
 				auto projectile = entity.GetComponent<ProjectileComponent>();
 
 				// Kill projectiles after thay reach their duration limit
 				if (SDL_GetTicks() - projectile.startTime > projectile.duration) {
-					entity.Kill(); 
+					commands.KillEntity(entity);
 				}
 			}
 		}
@@ -4,6 +4,7 @@
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/BoxColliderComponent.h"
+#include "../Resources/GameResources.h"
 
 #include <SDL.h>
 
@@ -14,7 +15,10 @@ class RenderColliderSystem : public System {
 			RequireComponent<BoxColliderComponent>();
 		}
 
-		void Update(SDL_Renderer* renderer, SDL_Rect& camera) {
+		void Update(Registry& registry) {
+			SDL_Renderer* renderer = registry.Resource<RenderContext>().renderer;
+			const auto& camera = registry.Resource<Camera>().view;
+
 			for (auto entity : GetSystemEntities()) {
 				const auto transform = entity.GetComponent<TransformComponent>();
 				const auto collider = entity.GetComponent<BoxColliderComponent>();
@@ -10,13 +10,23 @@
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/ProjectileEmitterComponent.h"
 #include "../Components/HealthComponent.h"
+#include "../Resources/GameResources.h"
 
 class RenderGUISystem : public System
 {	
+	private:
+		// Blueprint of the spawned enemies, the GUI inputs override the rest of the components
+		Prefab enemyPrefab;
+
 	public:
-		RenderGUISystem() = default;
+		RenderGUISystem() {
+			enemyPrefab.Group("enemies");
+			enemyPrefab.AddComponent<BoxColliderComponent>(25, 20, glm::vec2(5, 5));
+		}
+
+		void Update(Registry& registry) {
+			const auto& camera = registry.Resource<Camera>().view;
 
-		void Update(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera) {
 			ImGui::NewFrame();
 
 			// Display a window to customize and create new enemies
@@ -81,16 +91,14 @@ class RenderGUISystem : public System
 				ImGui::Spacing();
 
 				if(ImGui::Button("Spawn new enemy")) {
-					Entity enemy = registry->CreateEntity();
-					enemy.Group("enemies");
-					enemy.AddComponent<TransformComponent>(glm::vec2(XPos, YPos), glm::vec2(scaleX, scaleY), glm::degrees(rotation));
-					enemy.AddComponent<RigidBodyComponent>(glm::vec2(velX, velY));
-					enemy.AddComponent<SpriteComponent>(sprites[selectedSpriteIndex], 32, 32, 2);
-					enemy.AddComponent<BoxColliderComponent>(25, 20, glm::vec2(5, 5));
 					double projVelX = cos(projAngle) * projSpeed;
 					double projVelY = sin(projAngle) * projSpeed;
-					enemy.AddComponent<ProjectileEmitterComponent>(glm::vec2(projVelX, projVelY), projRepeat * 1000, projDuration * 1000, 10, false);
-					enemy.AddComponent<HealthComponent>(health);
+					registry.Instantiate(enemyPrefab,
+						TransformComponent(glm::vec2(XPos, YPos), glm::vec2(scaleX, scaleY), glm::degrees(rotation)),
+						RigidBodyComponent(glm::vec2(velX, velY)),
+						SpriteComponent(sprites[selectedSpriteIndex], 32, 32, 2),
+						ProjectileEmitterComponent(glm::vec2(projVelX, projVelY), projRepeat * 1000, projDuration * 1000, 10, false),
+						HealthComponent(health));
 
 					// Reset all input values after spawning enemy
 					XPos = YPos = scaleX = scaleY = rotation = projAngle = 0;
@@ -6,11 +6,85 @@
 #include "../Components/TransformComponent.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/HealthComponent.h"
+#include "../Resources/GameResources.h"
 
 #include <SDL.h>
 #include <string>
 
 class RenderHealthBarSystem : public System {
+	private:
+		// Health text texture of an entity, rendered again only when its health changes
+		struct HealthLabel {
+			Entity entity = Entity(-1, -1);
+			SDL_Texture* texture = nullptr;
+			int width = 0;
+			int height = 0;
+		};
+
+		// [Vector index = entity id]
+		std::vector<HealthLabel> healthLabels;
+
+		// Change tick of the registry when the labels were last brought up to date
+		uint32_t lastTick = 0;
+
+		// Membership version of the system when the labels of the entities that left it were last destroyed
+		uint32_t labelsMembershipVersion = 0;
+
+		SDL_Color GetHealthBarColor(int healthPercentage) const {
+			SDL_Color healthBarColor = { 255,255,255 };
+
+			if (healthPercentage >= 0 && healthPercentage < 40) {
+				// RED
+				healthBarColor = { 255, 0 ,0 };
+			}
+			if (healthPercentage >= 40 && healthPercentage < 80) {
+				// YELLOW
+				healthBarColor = { 255, 255 ,0 };
+			}
+			if (healthPercentage >= 80 && healthPercentage <= 100) {
+				// GREEN
+				healthBarColor = { 0, 255 ,0 };
+			}
+			return healthBarColor;
+		}
+
+		HealthLabel& RenderHealthLabel(Entity entity, int healthPercentage, SDL_Renderer* renderer, AssetStore* assetStore) {
+			if (entity.GetId() >= static_cast<int>(healthLabels.size())) {
+				healthLabels.resize(entity.GetId() + 1);
+			}
+			auto& label = healthLabels[entity.GetId()];
+			if (label.texture) {
+				SDL_DestroyTexture(label.texture);
+			}
+
+			std::string healthText = std::to_string(healthPercentage);
+			SDL_Surface* surface = TTF_RenderText_Blended(assetStore->GetFont("pico8-font-5"), healthText.c_str(), GetHealthBarColor(healthPercentage));
+			label.texture = SDL_CreateTextureFromSurface(renderer, surface);
+			SDL_FreeSurface(surface);
+
+			label.entity = entity;
+			SDL_QueryTexture(label.texture, NULL, NULL, &label.width, &label.height);
+			return label;
+		}
+
+		// Destroy the labels of the entities that are not in the system anymore (killed, or without health)
+		void ReleaseUnusedLabels() {
+			std::vector<bool> isLabelUsed(healthLabels.size(), false);
+			for (auto entity : GetSystemEntities()) {
+				const int entityId = entity.GetId();
+				if (entityId < static_cast<int>(healthLabels.size()) && healthLabels[entityId].entity == entity) {
+					isLabelUsed[entityId] = true;
+				}
+			}
+			for (size_t entityId = 0; entityId < healthLabels.size(); entityId++) {
+				auto& label = healthLabels[entityId];
+				if (label.texture && !isLabelUsed[entityId]) {
+					SDL_DestroyTexture(label.texture);
+					label = HealthLabel();
+				}
+			}
+		}
+
 	public:
 
 		RenderHealthBarSystem() {
@@ -19,27 +93,42 @@ class RenderHealthBarSystem : public System {
 			RequireComponent<HealthComponent>();
 		}
 
-		void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
+		// Destroy the cached textures, must be called before the renderer is destroyed
+		void ClearHealthLabels() {
+			for (auto& label : healthLabels) {
+				if (label.texture) {
+					SDL_DestroyTexture(label.texture);
+				}
+			}
+			healthLabels.clear();
+		}
+
+		void Update(Registry& registry) {
+			const auto& context = registry.Resource<RenderContext>();
+			SDL_Renderer* renderer = context.renderer;
+			AssetStore* assetStore = context.assetStore;
+			const auto& camera = registry.Resource<Camera>().view;
+
+			// Entities joined or left the system since the last frame, free the labels of the ones that left
+			if (GetMembershipVersion() != labelsMembershipVersion) {
+				ReleaseUnusedLabels();
+				labelsMembershipVersion = GetMembershipVersion();
+			}
+
+			// Render the health text again only for the entities whose health changed since the last frame
+			registry.View<HealthComponent, TransformComponent, SpriteComponent>(Without<>(), Changed<HealthComponent>(lastTick))
+				.Each([&](Entity entity, const HealthComponent& health, const TransformComponent&, const SpriteComponent&) {
+					RenderHealthLabel(entity, health.heathPercentage, renderer, assetStore);
+				});
+			lastTick = registry.GetTick();
+
 			for (auto entity : GetSystemEntities()) {
-				const auto transform = entity.GetComponent<TransformComponent>();
-				const auto sprite = entity.GetComponent<SpriteComponent>();
-				const auto health = entity.GetComponent<HealthComponent>();
+				const auto& transform = entity.GetComponent<TransformComponent>();
+				const auto& sprite = entity.GetComponent<SpriteComponent>();
+				const auto& health = entity.GetComponent<HealthComponent>();
 
 				// Draw a health bar with HP
-				SDL_Color healthBarColor = { 255,255,255 };
-
-				if (health.heathPercentage >= 0 && health.heathPercentage < 40) {
-					// RED
-					healthBarColor = { 255, 0 ,0 };
-				}
-				if (health.heathPercentage >= 40 && health.heathPercentage < 80) {
-					// YELLOW
-					healthBarColor = { 255, 255 ,0 };
-				}
-				if (health.heathPercentage >= 80 && health.heathPercentage <= 100) {
-					// GREEN
-					healthBarColor = { 0, 255 ,0 };
-				}
+				SDL_Color healthBarColor = GetHealthBarColor(health.heathPercentage);
 
 				// Positon of the health bar 
 				int healthBarWidth = 15;
@@ -56,30 +145,18 @@ class RenderHealthBarSystem : public System {
 				SDL_SetRenderDrawColor(renderer, healthBarColor.r, healthBarColor.g, healthBarColor.b, 255);
 				SDL_RenderFillRect(renderer, &healthBarRectangle);
 
-				// Render Health Text
-				std::string healthText = std::to_string(health.heathPercentage);
-				SDL_Surface* surface = TTF_RenderText_Blended(assetStore->GetFont("pico8-font-5"), healthText.c_str(), healthBarColor);
-				SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-				SDL_FreeSurface(surface);
-
-				int labelWidth = 0;
-				int labelHeight = 0;
-				
-		
-
-				SDL_QueryTexture(texture, NULL, NULL, &labelWidth, &labelHeight);
+				// Render Health Text, the label of an entity id can still belong to a previous entity
+				const bool hasLabel = entity.GetId() < static_cast<int>(healthLabels.size()) && healthLabels[entity.GetId()].entity == entity;
+				const HealthLabel& label = hasLabel ? healthLabels[entity.GetId()] : RenderHealthLabel(entity, health.heathPercentage, renderer, assetStore);
 
 				SDL_Rect healthBarTextRectangle = {
 					static_cast<int>(healthBarPosX),
 					static_cast<int>(healthBarPosY) + 5,
-					labelWidth,
-					labelHeight
+					label.width,
+					label.height
 				};
 
-
-				SDL_RenderCopy(renderer, texture, NULL, &healthBarTextRectangle);
-
-				SDL_DestroyTexture(texture);
+				SDL_RenderCopy(renderer, label.texture, NULL, &healthBarTextRectangle);
 			}
 		}
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "../Components/TransformComponent.h"
 #include "../Components/SpriteComponent.h"
 #include "../AssetStore/AssetStore.h"
+#include "../Resources/GameResources.h"
 #include <SDL.h>
 #include <algorithm>
 
@@ -15,43 +16,38 @@ public:
 		RequireComponent<SpriteComponent>();
 	}
 
-	void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, SDL_Rect& camera) {
+	void Update(Registry& registry) {
+		const auto& context = registry.Resource<RenderContext>();
+		SDL_Renderer* renderer = context.renderer;
+		AssetStore* assetStore = context.assetStore;
+		const auto& camera = registry.Resource<Camera>().view;
 
-		// Sort all the entities by z-index
-
-		// 1. Create a vector with both Sprite and Transform component of all entities
-		struct RenderableEntity {
-			TransformComponent transformComponent;
-			SpriteComponent spriteComponent;
-		};
-		std::vector<RenderableEntity> renderableEntities;
-		for (auto entity : GetSystemEntities()) {
-			RenderableEntity renderableEntity;
-			renderableEntity.spriteComponent = entity.GetComponent<SpriteComponent>();
-			renderableEntity.transformComponent = entity.GetComponent<TransformComponent>();
+		// Keep the sprite pool ordered by z-index: only the sprites added, removed or with a new z-index since the last frame move
+		registry.SortComponentsIncremental<SpriteComponent>([](const SpriteComponent& a, const SpriteComponent& b) {
+			return a.zIndex < b.zIndex;
+		});
 
-			// Check if the entity is within the camera view
-			if ((renderableEntity.transformComponent.position.x + (renderableEntity.spriteComponent.width * renderableEntity.transformComponent.scale.x) < camera.x ||
-				renderableEntity.transformComponent.position.y + (renderableEntity.spriteComponent.height * renderableEntity.transformComponent.scale.y) < camera.y ||
-				renderableEntity.transformComponent.position.x > camera.x + camera.w ||
-				renderableEntity.transformComponent.position.y > camera.y + camera.h) && !renderableEntity.spriteComponent.isFixed) {
+		// Walk the sprites in draw order
+		const auto sprites = registry.GetComponents<SpriteComponent>();
+		const auto spriteEntityIds = registry.GetComponentEntityIds<SpriteComponent>();
+		for (size_t i = 0; i < sprites.size(); i++) {
+			// Skip the sprites of entities without a transform, and the sprites removed this frame: the pool
+			// keeps them until the next Update()
+			const Entity entity = registry.GetEntity(spriteEntityIds[i]);
+			if (!registry.HasComponent<TransformComponent>(entity) || !registry.HasComponent<SpriteComponent>(entity)) {
 				continue;
 			}
 
-			renderableEntities.emplace_back(renderableEntity);
-		}
-
-		// 2. Sort the vector by the z-index value
-		std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, const RenderableEntity& b) {
-			return a.spriteComponent.zIndex < b.spriteComponent.zIndex;
-		});
-
-		// Loop all entities that the system is interested in 
-		for (auto entity : renderableEntities) {
+			const auto& transform = registry.GetComponent<TransformComponent>(entity);
+			const auto& sprite = sprites[i];
 
-			// Update entity position based on its velocity every frame of the game loop 
-			const auto transform = entity.transformComponent;
-			const auto sprite = entity.spriteComponent;
+			// Check if the entity is within the camera view
+			if ((transform.position.x + (sprite.width * transform.scale.x) < camera.x ||
+				transform.position.y + (sprite.height * transform.scale.y) < camera.y ||
+				transform.position.x > camera.x + camera.w ||
+				transform.position.y > camera.y + camera.h) && !sprite.isFixed) {
+				continue;
+			}
 
 			// Set the source rectangle of our original sprite texture
 			SDL_Rect srcRect = sprite.srcRect;
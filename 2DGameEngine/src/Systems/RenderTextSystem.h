@@ -4,6 +4,7 @@
 #include "../AssetStore/AssetStore.h"
 
 #include "../Components/TextLabelComponent.h"
+#include "../Resources/GameResources.h"
 
 #include <SDL.h>
 
@@ -13,7 +14,12 @@ class RenderTextSystem : public System {
 			RequireComponent<TextLabelComponent>();
 		}
 
-		void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
+		void Update(Registry& registry) {
+			const auto& context = registry.Resource<RenderContext>();
+			SDL_Renderer* renderer = context.renderer;
+			AssetStore* assetStore = context.assetStore;
+			const auto& camera = registry.Resource<Camera>().view;
+
 			for (auto entity : GetSystemEntities()) {
 				const auto textLabel = entity.GetComponent<TextLabelComponent>();
 